@@ -4,6 +4,7 @@
 #include <stdexcept>
 #include <fstream>
 #include <ctime>
+#include "trace.h"
 
 namespace fs = std::filesystem;
 
@@ -37,6 +38,7 @@ public:
     FileMover(const std::string &logFile) : logger(logFile) {}
 
     void moveFile(const std::string &source, const std::string &destination) {
+        AIK_TRACE_SCOPE("moveFile");
         if (fs::exists(source)) {
             try {
                 fs::rename(source, destination);
@@ -1,12 +1,54 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+#include <cstdlib>
 #include <opencv2/opencv.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <stdexcept>
+#include "trace.h"
+
+// 增量处理配置：画面按 tile_size 分块，每帧在每块内按 tile_size / signature_samples 的间距稀疏采样
+// signature_samples × signature_samples 个像素，采样点的灰度与缓存输出相差超过 threshold 时重新处理该块，
+// 否则复用缓存的输出。采样点的偏移每帧移动一个位置，(tile_size / signature_samples)² 帧内覆盖每个像素，
+// 包括右侧和底部不足一个间距的边角，因此局部变化最多滞后这么多帧。此外每 refresh_interval 帧轮流强制
+// 刷新每个块一次（各块错开），用于补上低于阈值的变化；为 0 时不强制刷新。
+struct IncrementalConfig {
+    int tile_size = 32;
+    int signature_samples = 8;
+    double threshold = 8.0;
+    int refresh_interval = 30;
+};
+
+struct IncrementalStats {
+    uint64_t frames = 0;
+    uint64_t full_frames = 0;   // 首帧、分辨率或格式变化时整帧处理
+    uint64_t cached_frames = 0; // 没有块发生变化（可能仍有轮流刷新的块）
+    uint64_t tiles_total = 0;
+    uint64_t tiles_processed = 0; // 包括强制刷新的块
+    uint64_t tiles_refreshed = 0; // 签名未变化、因轮流刷新而处理的块
+    uint64_t tiles_skipped = 0;
+
+    double tile_skip_ratio() const {
+        return tiles_total == 0 ? 0.0 : static_cast<double>(tiles_skipped) / tiles_total;
+    }
+
+    double frame_hit_ratio() const {
+        return frames == 0 ? 0.0 : static_cast<double>(cached_frames) / frames;
+    }
+};
 
 class ImageProcessor {
 public:
-    ImageProcessor(const std::string& log_file) : log_file_(log_file) {
+    ImageProcessor(const std::string& log_file, const IncrementalConfig& config = IncrementalConfig())
+        : log_file_(log_file), config_(config) {
+        if (config_.tile_size <= 0 || config_.signature_samples <= 0 ||
+            config_.tile_size % config_.signature_samples != 0 || config_.refresh_interval < 0) {
+            throw std::invalid_argument("Invalid incremental processing configuration");
+        }
+
         // 初始化日志文件
         std::ofstream ofs(log_file_, std::ios::out | std::ios::app);
         if (!ofs) {
@@ -17,13 +59,17 @@ public:
     }
 
     void capture_image() {
+        AIK_TRACE_SCOPE("capture_image");
         cv::VideoCapture cap(0); // 打开默认摄像头
         if (!cap.isOpened()) {
             throw std::runtime_error("Failed to open camera");
         }
 
         cv::Mat frame;
-        cap >> frame; // 抓取一帧图像
+        {
+            AIK_TRACE_SCOPE("grab_frame");
+            cap >> frame; // 抓取一帧图像
+        }
 
         if (frame.empty()) {
             throw std::runtime_error("Captured empty frame");
@@ -32,15 +78,167 @@ public:
         process_image(frame);
     }
 
+    // 连续采集模式：只重新处理画面中变化的块，max_frames <= 0 时一直运行到按下 Esc
+    void capture_stream(int max_frames) {
+        AIK_TRACE_SCOPE("capture_stream");
+        cv::VideoCapture cap(0); // 打开默认摄像头
+        if (!cap.isOpened()) {
+            throw std::runtime_error("Failed to open camera");
+        }
+
+        const std::string window_name = "Processed Image";
+        cv::Mat frame;
+        for (int i = 0; max_frames <= 0 || i < max_frames; ++i) {
+            {
+                AIK_TRACE_SCOPE("grab_frame");
+                cap >> frame;
+            }
+            if (frame.empty()) {
+                throw std::runtime_error("Captured empty frame");
+            }
+
+            const cv::Mat& gray_image = process_frame_incremental(frame);
+            {
+                AIK_TRACE_SCOPE("display_frame");
+                cv::imshow(window_name, gray_image);
+            }
+            if (stats_.frames % 100 == 0) {
+                log_stats();
+            }
+            // 定期写出追踪数据，被 Ctrl-C 终止时不至于丢失整段会话
+            if (stats_.frames % 1000 == 0) {
+                AIK_TRACE_FLUSH();
+            }
+            if (cv::waitKey(1) == 27) {
+                break;
+            }
+        }
+        log_stats();
+    }
+
+    // 处理一帧并返回缓存的输出，未变化的块直接沿用上一次的结果
+    const cv::Mat& process_frame_incremental(const cv::Mat& frame) {
+        AIK_TRACE_SCOPE("process_frame_incremental");
+        const int tile = config_.tile_size;
+        const int tiles_x = (frame.cols + tile - 1) / tile;
+        const int tiles_y = (frame.rows + tile - 1) / tile;
+        const uint64_t tiles = static_cast<uint64_t>(tiles_x) * tiles_y;
+        ++stats_.frames;
+        stats_.tiles_total += tiles;
+
+        // 采样只支持 8 位三通道图像，其它格式每帧整帧处理
+        const bool full = frame.type() != CV_8UC3 || frame.type() != cached_frame_type_ ||
+                          frame.size() != cached_frame_size_ || cached_output_.empty();
+        if (full) {
+            {
+                AIK_TRACE_SCOPE("convert_gray");
+                convert_region(frame, cached_output_);
+            }
+            cached_frame_size_ = frame.size();
+            cached_frame_type_ = frame.type();
+            ++stats_.full_frames;
+            stats_.tiles_processed += tiles;
+            AIK_TRACE_COUNTER("tiles_processed", tiles);
+            return cached_output_;
+        }
+
+        // 本帧采样点在间距内的偏移，逐帧遍历 cell × cell 个位置
+        const int cell = tile / config_.signature_samples;
+        const uint64_t phase = stats_.frames % (static_cast<uint64_t>(cell) * cell);
+        const cv::Point offset(static_cast<int>(phase % cell), static_cast<int>(phase / cell));
+        uint64_t changed = 0;
+        uint64_t refreshed = 0;
+        for (int ty = 0; ty < tiles_y; ++ty) {
+            for (int tx = 0; tx < tiles_x; ++tx) {
+                const cv::Rect roi = tile_rect(frame, tx, ty);
+                const bool is_changed = sampled_change(frame, roi, cell, offset);
+                const uint64_t index = static_cast<uint64_t>(ty) * tiles_x + tx;
+                const bool refresh = config_.refresh_interval > 0 &&
+                                     (stats_.frames + index) % static_cast<uint64_t>(config_.refresh_interval) == 0;
+                if (!is_changed && !refresh) {
+                    continue;
+                }
+                cv::Mat output_tile = cached_output_(roi);
+                convert_region(frame(roi), output_tile);
+                if (is_changed) {
+                    ++changed;
+                } else {
+                    ++refreshed;
+                }
+            }
+        }
+
+        stats_.tiles_processed += changed + refreshed;
+        stats_.tiles_refreshed += refreshed;
+        stats_.tiles_skipped += tiles - changed - refreshed;
+        if (changed == 0) {
+            ++stats_.cached_frames;
+        }
+        AIK_TRACE_COUNTER("tiles_processed", changed + refreshed);
+        return cached_output_;
+    }
+
+    const IncrementalStats& incremental_stats() const {
+        return stats_;
+    }
+
 private:
     std::string log_file_;
+    IncrementalConfig config_;
+    IncrementalStats stats_;
+    cv::Mat cached_output_;
+    cv::Size cached_frame_size_;
+    int cached_frame_type_ = -1;
+
+    // 转换为灰度图像；dst 是缓存输出的 ROI 时 cvtColor 直接写入其中，不会重新分配
+    static void convert_region(const cv::Mat& src, cv::Mat& dst) {
+        cv::cvtColor(src, dst, cv::COLOR_BGR2GRAY);
+    }
+
+    cv::Rect tile_rect(const cv::Mat& frame, int tx, int ty) const {
+        const int x = tx * config_.tile_size;
+        const int y = ty * config_.tile_size;
+        return cv::Rect(x, y, std::min(config_.tile_size, frame.cols - x), std::min(config_.tile_size, frame.rows - y));
+    }
+
+    // 与缓存输出比较，即与块上次处理时的结果比较，而不是与上一帧比较，避免缓慢变化逐帧累积而始终不被处理。
+    // 灰度按 cvtColor 的定点系数计算，未变化的像素差值为 0；块比偏移还窄时本帧不采样。
+    bool sampled_change(const cv::Mat& frame, const cv::Rect& roi, int cell, const cv::Point& offset) const {
+        for (int y = roi.y + offset.y; y < roi.y + roi.height; y += cell) {
+            const uchar* src = frame.ptr<uchar>(y);
+            const uchar* cached = cached_output_.ptr<uchar>(y);
+            for (int x = roi.x + offset.x; x < roi.x + roi.width; x += cell) {
+                const uchar* pixel = src + 3 * x;
+                const int gray = (pixel[0] * 1868 + pixel[1] * 9617 + pixel[2] * 4899 + (1 << 13)) >> 14;
+                if (std::abs(gray - cached[x]) > config_.threshold) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void log_stats() {
+        std::ostringstream message;
+        message << "Incremental stats: frames=" << stats_.frames << " full_frames=" << stats_.full_frames
+                << " cached_frames=" << stats_.cached_frames << " tiles_processed=" << stats_.tiles_processed
+                << " tiles_refreshed=" << stats_.tiles_refreshed << " tiles_skipped=" << stats_.tiles_skipped
+                << " tile_skip_ratio=" << stats_.tile_skip_ratio() << " frame_hit_ratio=" << stats_.frame_hit_ratio();
+        log_info(message.str());
+    }
 
     void process_image(const cv::Mat& image) {
         cv::Mat gray_image;
-        cv::cvtColor(image, gray_image, cv::COLOR_BGR2GRAY); // 转换为灰度图像
+        {
+            AIK_TRACE_SCOPE("convert_gray");
+            convert_region(image, gray_image); // 转换为灰度图像
+        }
 
-        std::string window_name = "Processed Image";
-        cv::imshow(window_name, gray_image); // 显示处理后的图像
+        {
+            AIK_TRACE_SCOPE("display_frame");
+            std::string window_name = "Processed Image";
+            cv::imshow(window_name, gray_image); // 显示处理后的图像
+        }
         log_info("Image processed and displayed");
 
         cv::waitKey(0);
@@ -59,12 +257,17 @@ private:
     }
 };
 
-int main() {
+int main(int argc, char* argv[]) {
     const std::string log_file = "image_processing.log";
 
     try {
         ImageProcessor processor(log_file);
-        processor.capture_image();
+        if (argc > 1 && std::string(argv[1]) == "--stream") {
+            // 连续采集，可选参数为帧数，省略时一直运行到按下 Esc
+            processor.capture_stream(argc > 2 ? std::stoi(argv[2]) : 0);
+        } else {
+            processor.capture_image();
+        }
     } catch (const std::runtime_error& e) {
         std::cerr << "Runtime error: " << e.what() << std::endl;
         return 1;
@@ -3,6 +3,7 @@
 #include <stdexcept>
 #include <string>
 #include <spdlog/spdlog.h>
+#include "trace.h"
 
 class MusicGenerator {
 public:
@@ -24,19 +25,26 @@ MusicGenerator::MusicGenerator(const std::string& outputDirectory, const std::st
 }
 
 void MusicGenerator::generateTone(int frequency, int duration) {
+    AIK_TRACE_SCOPE("generateTone");
     const int sampleRate = 44100; // 44.1 kHz
     const int totalSamples = sampleRate * duration;
     std::vector<char> buffer(totalSamples * 2); // 16-bit PCM
 
     // Create a simple sine wave tone
-    for (int i = 0; i < totalSamples; ++i) {
-        float amplitude = 32767.0f; // Maximum amplitude for 16-bit PCM
-        float sample = amplitude * sin((2.0 * M_PI * frequency * i) / sampleRate);
-        int16_t intSample = static_cast<int16_t>(sample);
-        buffer[i * 2] = intSample & 0xff; // Low byte
-        buffer[i * 2 + 1] = (intSample >> 8) & 0xff; // High byte
+    {
+        AIK_TRACE_SCOPE("synthesize");
+        AIK_TRACE_COUNTER("samples", totalSamples);
+        for (int i = 0; i < totalSamples; ++i) {
+            float amplitude = 32767.0f; // Maximum amplitude for 16-bit PCM
+            float sample = amplitude * sin((2.0 * M_PI * frequency * i) / sampleRate);
+            int16_t intSample = static_cast<int16_t>(sample);
+            buffer[i * 2] = intSample & 0xff; // Low byte
+            buffer[i * 2 + 1] = (intSample >> 8) & 0xff; // High byte
+        }
     }
 
+    AIK_TRACE_SCOPE("write_wav");
+
     // Write WAV file header
     std::ofstream outFile(outputPath, std::ios::binary);
     if (!outFile) {
@@ -6,6 +6,7 @@
 #include <stdexcept>
 #include <portaudio.h>
 #include <sndfile.h>
+#include "trace.h"
 
 // 日志类
 class Logger {
@@ -47,6 +48,7 @@ public:
     }
 
     void generatePianoPiece(const std::vector<std::pair<std::string, int>> &pianoScore, const std::string &filename) {
+        AIK_TRACE_SCOPE("generatePianoPiece");
         int sampleRate = 44100; // 采样率
         int totalDuration = 0;   // 初始化总时长
         for (const auto &note : pianoScore) {
@@ -69,17 +71,22 @@ public:
         int index = 0;
 
         for (const auto &note : pianoScore) {
+            AIK_TRACE_SCOPE("synthesize_note");
             double frequency = noteNameToFrequency(note.first);
             int duration = note.second;
 
             for (int t = 0; t < duration * sampleRate / 1000; ++t) {
                 audioBuffer[index++] += 0.5 * std::sin(2 * M_PI * frequency * (t / (double)sampleRate));
             }
+            AIK_TRACE_COUNTER("samples_written", index);
         }
 
         // 将生成的数据写入文件
-        sf_write_double(outfile, audioBuffer.data(), audioBuffer.size());
-        sf_close(outfile);
+        {
+            AIK_TRACE_SCOPE("write_wav");
+            sf_write_double(outfile, audioBuffer.data(), audioBuffer.size());
+            sf_close(outfile);
+        }
         Logger::logInfo("Piano piece generated and saved to " + filename);
     }
 };
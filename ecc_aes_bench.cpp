@@ -0,0 +1,448 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/rand.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC 1
+#endif
+
+#include "ecc_aes_core.h"
+#include "ecc_aes_file.h"
+
+using ecc_aes::ByteSpan;
+using ecc_aes::EnvelopeOpener;
+using ecc_aes::EnvelopeSealer;
+using ecc_aes::MutableByteSpan;
+using ecc_aes::RecipientKey;
+using ecc_aes::RecipientPrivateKey;
+
+// 加解密吞吐量基准：对 负载大小 × 缓冲区大小 × 模式(CBC/GCM) × 线程数 × 路径(内存/文件)
+// 做笛卡尔积扫描，每个组合每个方向输出一行 JSON，便于脚本比较前后两次运行。
+//
+// CBC 是原来的单流 AES-256-CBC 路径，只能单线程，缓冲区大小即每次 EVP_*Update 的块大小；
+// GCM 是分段容器，缓冲区大小即段大小。
+//
+// 文件路径和密钥文件都放在 --tmp-dir 下用 mkdtemp 新建的私有目录 (0700) 中，结束时删除。
+
+struct BenchConfig {
+    std::vector<uint64_t> sizes{4ull << 10, 64ull << 10, 1ull << 20, 16ull << 20, 256ull << 20};
+    std::vector<uint64_t> buffers{16ull << 10, 64ull << 10, 1ull << 20};
+    std::vector<unsigned int> threads{1, std::max(1u, std::thread::hardware_concurrency())};
+    std::vector<std::string> modes{"cbc", "gcm"};
+    std::vector<std::string> paths{"memory", "file"};
+    double min_time = 0.5;
+    std::string tmp_dir = "/tmp";
+};
+
+struct BenchResult {
+    uint64_t iterations;
+    double seconds;
+    uint64_t cycles;
+};
+
+static uint64_t readCycles() {
+#ifdef HAVE_RDTSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// 重复执行 fn 直到累计时间达到 min_time（至少一次）
+template <typename Fn>
+static BenchResult measure(double min_time, Fn fn) {
+    BenchResult result{0, 0.0, 0};
+    while (result.iterations == 0 || result.seconds < min_time) {
+        const auto start = std::chrono::steady_clock::now();
+        const uint64_t start_cycles = readCycles();
+        fn();
+        result.cycles += readCycles() - start_cycles;
+        result.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        ++result.iterations;
+    }
+    return result;
+}
+
+static void report(const std::string& path, const std::string& mode, const char* op, uint64_t payload,
+                   uint64_t buffer, unsigned int threads, const BenchResult& r) {
+    const double bytes = static_cast<double>(payload) * r.iterations;
+    std::ostringstream line;
+    line << "{\"path\":\"" << path << "\",\"mode\":\"" << mode << "\",\"op\":\"" << op << "\""
+         << ",\"payload_bytes\":" << payload << ",\"buffer_bytes\":" << buffer << ",\"threads\":" << threads
+         << ",\"iterations\":" << r.iterations << ",\"seconds\":" << r.seconds
+         << ",\"mb_per_s\":" << bytes / r.seconds / 1e6 << ",\"cycles_per_byte\":";
+#ifdef HAVE_RDTSC
+    line << static_cast<double>(r.cycles) / bytes;
+#else
+    line << "null";
+#endif
+    line << "}";
+    std::cout << line.str() << std::endl;
+}
+
+static uint64_t parseSize(const std::string& text) {
+    size_t pos = 0;
+    uint64_t value = std::stoull(text, &pos);
+    if (pos < text.size()) {
+        switch (text[pos]) {
+        case 'K': case 'k': value <<= 10; break;
+        case 'M': case 'm': value <<= 20; break;
+        case 'G': case 'g': value <<= 30; break;
+        default: throw std::invalid_argument("Invalid size: " + text);
+        }
+    }
+    return value;
+}
+
+static std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+static BenchConfig parseArgs(int argc, char* argv[]) {
+    BenchConfig config;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const size_t eq = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos) {
+            throw std::invalid_argument("Unknown argument: " + arg);
+        }
+        const std::string name = arg.substr(2, eq - 2);
+        const std::string value = arg.substr(eq + 1);
+        if (name == "sizes" || name == "buffers") {
+            std::vector<uint64_t>& target = name == "sizes" ? config.sizes : config.buffers;
+            target.clear();
+            for (const auto& item : splitList(value)) {
+                target.push_back(parseSize(item));
+            }
+            // GCM 的段大小和 CBC 的 Update 块大小共用同一上限，超出的值会在扫描中途失败
+            if (name == "buffers") {
+                for (uint64_t buffer : target) {
+                    if (buffer == 0 || buffer > ECC_AES_MAX_SEGMENT_SIZE) {
+                        throw std::invalid_argument("Buffer size must be between 1 and 16M: " + std::to_string(buffer));
+                    }
+                }
+            }
+        } else if (name == "threads") {
+            config.threads.clear();
+            for (const auto& item : splitList(value)) {
+                config.threads.push_back(static_cast<unsigned int>(std::max(1ul, std::stoul(item))));
+            }
+        } else if (name == "modes") {
+            config.modes = splitList(value);
+        } else if (name == "paths") {
+            config.paths = splitList(value);
+        } else if (name == "min-time") {
+            config.min_time = std::stod(value);
+        } else if (name == "tmp-dir") {
+            config.tmp_dir = value;
+        } else {
+            throw std::invalid_argument("Unknown argument: " + arg);
+        }
+    }
+    for (const auto& mode : config.modes) {
+        if (mode != "cbc" && mode != "gcm") {
+            throw std::invalid_argument("Unknown mode: " + mode);
+        }
+    }
+    std::sort(config.threads.begin(), config.threads.end());
+    config.threads.erase(std::unique(config.threads.begin(), config.threads.end()), config.threads.end());
+    return config;
+}
+
+// 生成一对临时 X25519 密钥，返回 PEM 编码的公钥和私钥
+static void generateKeyPair(std::string& public_pem, std::string& private_pem) {
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_X25519, nullptr);
+    EVP_PKEY* pkey = nullptr;
+    if (ctx == nullptr || EVP_PKEY_keygen_init(ctx) != 1 || EVP_PKEY_keygen(ctx, &pkey) != 1) {
+        EVP_PKEY_CTX_free(ctx);
+        throw std::runtime_error("Error generating benchmark key pair.");
+    }
+    EVP_PKEY_CTX_free(ctx);
+
+    BIO* pub = BIO_new(BIO_s_mem());
+    BIO* priv = BIO_new(BIO_s_mem());
+    PEM_write_bio_PUBKEY(pub, pkey);
+    PEM_write_bio_PrivateKey(priv, pkey, nullptr, nullptr, 0, nullptr, nullptr);
+    char* data = nullptr;
+    long len = BIO_get_mem_data(pub, &data);
+    public_pem.assign(data, len);
+    len = BIO_get_mem_data(priv, &data);
+    private_pem.assign(data, len);
+    BIO_free(pub);
+    BIO_free(priv);
+    EVP_PKEY_free(pkey);
+}
+
+// 基准运行期间的私有临时目录，析构时删除登记过的文件和目录本身
+class ScratchDir {
+private:
+    std::string path_;
+    std::vector<std::string> files_;
+
+public:
+    explicit ScratchDir(const std::string& parent) {
+        std::string pattern = parent + "/ecc_aes_bench.XXXXXX";
+        if (mkdtemp(&pattern[0]) == nullptr) {
+            throw std::runtime_error("Error creating temporary directory in " + parent + ".");
+        }
+        path_ = pattern;
+    }
+
+    ~ScratchDir() {
+        for (const auto& file : files_) {
+            std::remove(file.c_str());
+        }
+        rmdir(path_.c_str());
+    }
+
+    ScratchDir(const ScratchDir&) = delete;
+    ScratchDir& operator=(const ScratchDir&) = delete;
+
+    std::string file(const std::string& name) {
+        const std::string path = path_ + "/" + name;
+        if (std::find(files_.begin(), files_.end(), path) == files_.end()) {
+            files_.push_back(path);
+        }
+        return path;
+    }
+};
+
+// 新建文件并以 0600 权限写入，文件已存在（包括符号链接）时失败
+static void writeFile(const std::string& path, const std::string& contents) {
+    const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("Error creating " + path + ".");
+    }
+    size_t written = 0;
+    while (written < contents.size()) {
+        const ssize_t n = write(fd, contents.data() + written, contents.size() - written);
+        if (n <= 0) {
+            close(fd);
+            throw std::runtime_error("Error writing " + path + ".");
+        }
+        written += static_cast<size_t>(n);
+    }
+    close(fd);
+}
+
+// 原单流 AES-256-CBC 路径：每次 Update 处理一个缓冲区
+class CbcCipher {
+private:
+    EVP_CIPHER_CTX* ctx_;
+    unsigned char key_[ECC_AES_KEY_SIZE / 8];
+    unsigned char iv_[EVP_MAX_IV_LENGTH];
+
+public:
+    CbcCipher() : ctx_(EVP_CIPHER_CTX_new()) {
+        if (ctx_ == nullptr || RAND_bytes(key_, sizeof(key_)) != 1 || RAND_bytes(iv_, sizeof(iv_)) != 1) {
+            throw std::runtime_error("Error initializing CBC cipher.");
+        }
+    }
+
+    ~CbcCipher() {
+        EVP_CIPHER_CTX_free(ctx_);
+    }
+
+    CbcCipher(const CbcCipher&) = delete;
+    CbcCipher& operator=(const CbcCipher&) = delete;
+
+    // 返回写入 out 的字节数，out 需容纳 in.size + EVP_MAX_BLOCK_LENGTH 字节
+    size_t run(bool encrypt, ByteSpan in, unsigned char* out, size_t buffer_size) {
+        int len = 0;
+        size_t written = 0;
+        if (EVP_CipherInit_ex(ctx_, EVP_aes_256_cbc(), nullptr, key_, iv_, encrypt ? 1 : 0) != 1) {
+            throw std::runtime_error("Error initializing CBC cipher.");
+        }
+        for (size_t pos = 0; pos < in.size; pos += buffer_size) {
+            const int chunk = static_cast<int>(std::min(buffer_size, in.size - pos));
+            if (EVP_CipherUpdate(ctx_, out + written, &len, in.data + pos, chunk) != 1) {
+                throw std::runtime_error("Error in CBC update.");
+            }
+            written += len;
+        }
+        if (EVP_CipherFinal_ex(ctx_, out + written, &len) != 1) {
+            throw std::runtime_error("Error in CBC final.");
+        }
+        return written + len;
+    }
+
+    void runFile(bool encrypt, const std::string& input, const std::string& output, size_t buffer_size) {
+        std::ifstream in(input, std::ios::binary);
+        std::ofstream out(output, std::ios::binary);
+        std::vector<unsigned char> buffer(buffer_size);
+        std::vector<unsigned char> result(buffer_size + EVP_MAX_BLOCK_LENGTH);
+        int len = 0;
+        if (!in.is_open() || !out.is_open() ||
+            EVP_CipherInit_ex(ctx_, EVP_aes_256_cbc(), nullptr, key_, iv_, encrypt ? 1 : 0) != 1) {
+            throw std::runtime_error("Error initializing CBC file benchmark.");
+        }
+        while (in.read(reinterpret_cast<char*>(buffer.data()), buffer.size()) || in.gcount() > 0) {
+            if (EVP_CipherUpdate(ctx_, result.data(), &len, buffer.data(), static_cast<int>(in.gcount())) != 1) {
+                throw std::runtime_error("Error in CBC update.");
+            }
+            out.write(reinterpret_cast<char*>(result.data()), len);
+        }
+        if (EVP_CipherFinal_ex(ctx_, result.data(), &len) != 1) {
+            throw std::runtime_error("Error in CBC final.");
+        }
+        out.write(reinterpret_cast<char*>(result.data()), len);
+    }
+};
+
+// 每个组合在计时之外校验一次解密结果，避免给出错误实现的吞吐量
+static void checkRoundTrip(const std::string& mode, const std::vector<unsigned char>& plaintext, ByteSpan decrypted) {
+    if (decrypted.size != plaintext.size() || !std::equal(plaintext.begin(), plaintext.end(), decrypted.data)) {
+        throw std::runtime_error("Round trip mismatch in " + mode + " memory benchmark.");
+    }
+}
+
+static void benchMemory(const BenchConfig& config, const std::string& mode, uint64_t payload, uint64_t buffer,
+                        unsigned int threads, RecipientKey& recipient, const RecipientPrivateKey& private_key) {
+    std::vector<unsigned char> plaintext(static_cast<size_t>(payload));
+    RAND_bytes(plaintext.data(), static_cast<int>(std::min<uint64_t>(payload, 1 << 20)));
+
+    if (mode == "cbc") {
+        CbcCipher cipher;
+        std::vector<unsigned char> ciphertext(plaintext.size() + EVP_MAX_BLOCK_LENGTH);
+        std::vector<unsigned char> decrypted(ciphertext.size() + EVP_MAX_BLOCK_LENGTH);
+        size_t sealed = 0;
+        size_t opened = 0;
+        report("memory", mode, "encrypt", payload, buffer, threads, measure(config.min_time, [&] {
+            sealed = cipher.run(true, ByteSpan(plaintext), ciphertext.data(), buffer);
+        }));
+        report("memory", mode, "decrypt", payload, buffer, threads, measure(config.min_time, [&] {
+            opened = cipher.run(false, ByteSpan(ciphertext.data(), sealed), decrypted.data(), buffer);
+        }));
+        checkRoundTrip(mode, plaintext, ByteSpan(decrypted.data(), opened));
+        return;
+    }
+
+    EnvelopeSealer sealer(recipient, static_cast<uint32_t>(buffer), threads);
+    EnvelopeOpener opener(private_key, threads);
+    std::vector<unsigned char> ciphertext(sealer.sealedSize(plaintext.size()));
+    std::vector<unsigned char> decrypted(plaintext.size());
+    report("memory", mode, "encrypt", payload, buffer, threads, measure(config.min_time, [&] {
+        sealer.seal(ByteSpan(plaintext), MutableByteSpan(ciphertext));
+    }));
+    report("memory", mode, "decrypt", payload, buffer, threads, measure(config.min_time, [&] {
+        opener.open(ByteSpan(ciphertext), MutableByteSpan(decrypted));
+    }));
+    checkRoundTrip(mode, plaintext, ByteSpan(decrypted));
+}
+
+static void benchFile(const BenchConfig& config, ScratchDir& scratch, const std::string& mode, uint64_t payload,
+                      uint64_t buffer, unsigned int threads, const std::string& public_key_file,
+                      const std::string& private_key_file) {
+    const std::string plain = scratch.file("plain");
+    const std::string sealed = scratch.file("sealed");
+    const std::string opened = scratch.file("opened");
+    {
+        std::ofstream out(plain, std::ios::binary);
+        std::vector<char> chunk(1 << 20);
+        RAND_bytes(reinterpret_cast<unsigned char*>(chunk.data()), static_cast<int>(chunk.size()));
+        for (uint64_t written = 0; written < payload; written += chunk.size()) {
+            out.write(chunk.data(), static_cast<std::streamsize>(std::min<uint64_t>(chunk.size(), payload - written)));
+        }
+    }
+
+    if (mode == "cbc") {
+        CbcCipher cipher;
+        report("file", mode, "encrypt", payload, buffer, threads, measure(config.min_time, [&] {
+            cipher.runFile(true, plain, sealed, static_cast<size_t>(buffer));
+        }));
+        report("file", mode, "decrypt", payload, buffer, threads, measure(config.min_time, [&] {
+            cipher.runFile(false, sealed, opened, static_cast<size_t>(buffer));
+        }));
+    } else {
+        SecureECCAESFileEncryptor encryptor(plain.c_str(), sealed.c_str(), public_key_file.c_str());
+        SecureECCAESFileEncryptor decryptor(sealed.c_str(), opened.c_str(), private_key_file.c_str());
+        encryptor.set_segment_size(static_cast<uint32_t>(buffer));
+        encryptor.set_threads(threads);
+        decryptor.set_threads(threads);
+        report("file", mode, "encrypt", payload, buffer, threads, measure(config.min_time, [&] {
+            encryptor.runEncryption();
+        }));
+        report("file", mode, "decrypt", payload, buffer, threads, measure(config.min_time, [&] {
+            decryptor.runDecryption();
+        }));
+    }
+
+    std::remove(plain.c_str());
+    std::remove(sealed.c_str());
+    std::remove(opened.c_str());
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    try {
+        config = parseArgs(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        std::cerr << "Usage: " << argv[0] << " [--sizes=4K,1M,4G] [--buffers=16K,64K (1..16M)] [--threads=1,4]"
+                  << " [--modes=cbc,gcm] [--paths=memory,file] [--min-time=0.5] [--tmp-dir=/tmp]" << std::endl;
+        return 1;
+    }
+
+    try {
+        std::string public_pem;
+        std::string private_pem;
+        generateKeyPair(public_pem, private_pem);
+        RecipientKey recipient{ByteSpan(public_pem)};
+        RecipientPrivateKey private_key{ByteSpan(private_pem)};
+        ScratchDir scratch(config.tmp_dir);
+        const std::string public_key_file = scratch.file("pub.pem");
+        const std::string private_key_file = scratch.file("key.pem");
+        writeFile(public_key_file, public_pem);
+        writeFile(private_key_file, private_pem);
+
+        for (const auto& path : config.paths) {
+            for (const auto& mode : config.modes) {
+                for (uint64_t payload : config.sizes) {
+                    for (uint64_t buffer : config.buffers) {
+                        for (unsigned int threads : config.threads) {
+                            // CBC 是严格串行的，多线程组合没有意义
+                            if (mode == "cbc" && threads != 1) {
+                                continue;
+                            }
+                            if (path == "memory") {
+                                benchMemory(config, mode, payload, buffer, threads, recipient, private_key);
+                            } else if (path == "file") {
+                                benchFile(config, scratch, mode, payload, buffer, threads, public_key_file,
+                                          private_key_file);
+                            } else {
+                                throw std::invalid_argument("Unknown path: " + path);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
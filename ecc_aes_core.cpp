@@ -0,0 +1,921 @@
+#include "ecc_aes_core.h"
+#include "ecc_aes_internal.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <openssl/bio.h>
+#include <openssl/core_names.h>
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/kdf.h>
+#include <openssl/pem.h>
+#include <openssl/rand.h>
+
+namespace ecc_aes {
+
+static const unsigned char CONTAINER_MAGIC[4] = {'E', 'A', 'E', 'S'};
+static const char KEK_INFO[] = "anonymousAIK file_encryptor v2 key wrap";
+
+size_t kemPublicSize(unsigned char kem) {
+    switch (kem) {
+    case ECC_AES_KEM_X25519:
+        return ECC_AES_X25519_PUBLIC_SIZE;
+    case ECC_AES_KEM_P256:
+        return ECC_AES_P256_PUBLIC_SIZE;
+    default:
+        throw std::runtime_error("Unsupported key agreement scheme.");
+    }
+}
+
+size_t ContainerHeader::size() const {
+    return ECC_AES_CONTAINER_FIXED_HEADER_SIZE + kemPublicSize(kem) + ECC_AES_WRAPPED_KEY_SIZE;
+}
+
+std::vector<unsigned char> ContainerHeader::serializePrefix() const {
+    std::vector<unsigned char> out(ECC_AES_CONTAINER_FIXED_HEADER_SIZE, 0);
+    std::memcpy(out.data(), CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC));
+    out[4] = ECC_AES_CONTAINER_VERSION;
+    out[5] = kem;
+    out[8] = static_cast<unsigned char>(segment_size >> 24);
+    out[9] = static_cast<unsigned char>(segment_size >> 16);
+    out[10] = static_cast<unsigned char>(segment_size >> 8);
+    out[11] = static_cast<unsigned char>(segment_size);
+    std::memcpy(out.data() + 12, nonce_prefix, ECC_AES_NONCE_PREFIX_SIZE);
+    out.insert(out.end(), ephemeral_public.begin(), ephemeral_public.end());
+    return out;
+}
+
+std::vector<unsigned char> ContainerHeader::serialize() const {
+    std::vector<unsigned char> out = serializePrefix();
+    out.insert(out.end(), wrapped_key, wrapped_key + ECC_AES_WRAPPED_KEY_SIZE);
+    return out;
+}
+
+ContainerHeader ContainerHeader::parse(ByteSpan in) {
+    if (in.size < ECC_AES_CONTAINER_FIXED_HEADER_SIZE) {
+        throw std::runtime_error("Encrypted data is truncated.");
+    }
+    if (std::memcmp(in.data, CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC)) != 0) {
+        throw std::runtime_error("Input is not an encrypted container.");
+    }
+    if (in.data[4] != ECC_AES_CONTAINER_VERSION) {
+        throw std::runtime_error("Unsupported container version.");
+    }
+    // AAD 由 serialize() 重建，保留字节总是写 0；必须在这里拒绝非零值，否则它们不受认证保护
+    if (in.data[6] != 0 || in.data[7] != 0 || in.data[19] != 0) {
+        throw std::runtime_error("Invalid container header (reserved bytes must be zero).");
+    }
+    ContainerHeader header;
+    header.kem = in.data[5];
+    header.segment_size = (static_cast<uint32_t>(in.data[8]) << 24) | (static_cast<uint32_t>(in.data[9]) << 16) |
+                          (static_cast<uint32_t>(in.data[10]) << 8) | static_cast<uint32_t>(in.data[11]);
+    if (header.segment_size == 0 || header.segment_size > ECC_AES_MAX_SEGMENT_SIZE) {
+        throw std::runtime_error("Invalid container segment size.");
+    }
+    std::memcpy(header.nonce_prefix, in.data + 12, ECC_AES_NONCE_PREFIX_SIZE);
+
+    const size_t public_size = kemPublicSize(header.kem);
+    if (in.size < ECC_AES_CONTAINER_FIXED_HEADER_SIZE + public_size + ECC_AES_WRAPPED_KEY_SIZE) {
+        throw std::runtime_error("Encrypted data is truncated.");
+    }
+    const unsigned char* pub = in.data + ECC_AES_CONTAINER_FIXED_HEADER_SIZE;
+    header.ephemeral_public.assign(pub, pub + public_size);
+    std::memcpy(header.wrapped_key, pub + public_size, ECC_AES_WRAPPED_KEY_SIZE);
+    return header;
+}
+
+ContainerLayout ContainerLayout::forPlaintext(const ContainerHeader& header, uint64_t plaintext_size) {
+    // 空明文也输出一个带 last_flag 的空段，否则无法区分空内容与被截断的内容
+    ContainerLayout layout;
+    layout.header_size = header.size();
+    layout.stored_segment_size = static_cast<uint64_t>(header.segment_size) + ECC_AES_GCM_TAG_SIZE;
+    layout.segment_count = std::max<uint64_t>(1, (plaintext_size + header.segment_size - 1) / header.segment_size);
+    layout.plaintext_size = plaintext_size;
+    if (layout.segment_count - 1 > UINT32_MAX) {
+        throw std::runtime_error("Input too large for container format.");
+    }
+    return layout;
+}
+
+ContainerLayout ContainerLayout::forContainer(const ContainerHeader& header, uint64_t container_size) {
+    ContainerLayout layout;
+    layout.header_size = header.size();
+    layout.stored_segment_size = static_cast<uint64_t>(header.segment_size) + ECC_AES_GCM_TAG_SIZE;
+    if (container_size < layout.header_size + ECC_AES_GCM_TAG_SIZE) {
+        throw std::runtime_error("Encrypted data is truncated.");
+    }
+    const uint64_t body_size = container_size - layout.header_size;
+    layout.segment_count = (body_size + layout.stored_segment_size - 1) / layout.stored_segment_size;
+    if (body_size - (layout.segment_count - 1) * layout.stored_segment_size < ECC_AES_GCM_TAG_SIZE) {
+        throw std::runtime_error("Encrypted data is truncated.");
+    }
+    layout.plaintext_size = body_size - layout.segment_count * ECC_AES_GCM_TAG_SIZE;
+    return layout;
+}
+
+struct CipherContextPool::Entry {
+    EVP_CIPHER_CTX* ctx;
+    unsigned char key[ECC_AES_KEY_SIZE / 8];
+    int mode;   // 0: 未装载密钥, 1: 加密, 2: 解密
+    bool bound; // 是否已绑定 AES-256-GCM，绑定后重新装载密钥时不必再查找算法
+};
+
+namespace {
+
+// 线程退出时释放本线程借出过的全部上下文
+struct ThreadCipherContexts {
+    std::vector<CipherContextPool::Entry*> free;
+
+    ~ThreadCipherContexts() {
+        for (auto* entry : free) {
+            OPENSSL_cleanse(entry->key, sizeof(entry->key));
+            EVP_CIPHER_CTX_free(entry->ctx);
+            delete entry;
+        }
+    }
+};
+
+ThreadCipherContexts& threadCipherContexts() {
+    thread_local ThreadCipherContexts contexts;
+    return contexts;
+}
+
+} // namespace
+
+CipherContextPool::Lease CipherContextPool::acquire() {
+    auto& contexts = threadCipherContexts();
+    if (!contexts.free.empty()) {
+        Entry* entry = contexts.free.back();
+        contexts.free.pop_back();
+        return Lease(entry);
+    }
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    if (ctx == nullptr) {
+        throw std::runtime_error("Error allocating cipher context.");
+    }
+    Entry* entry = new Entry;
+    entry->ctx = ctx;
+    entry->mode = 0;
+    entry->bound = false;
+    return Lease(entry);
+}
+
+CipherContextPool::Lease::~Lease() {
+    // 归还到析构时所在线程的池中。密钥只在一次借用内复用：归还前用全零密钥覆盖
+    // 上下文中的密钥扩展并抹掉缓存的密钥，空闲的上下文不保留任何密钥材料
+    if (entry_ != nullptr) {
+        if (entry_->mode != 0) {
+            static const unsigned char zero_key[ECC_AES_KEY_SIZE / 8] = {0};
+            EVP_CipherInit_ex(entry_->ctx, nullptr, nullptr, zero_key, nullptr, -1);
+            OPENSSL_cleanse(entry_->key, sizeof(entry_->key));
+            entry_->mode = 0;
+        }
+        threadCipherContexts().free.push_back(entry_);
+    }
+}
+
+EVP_CIPHER_CTX* CipherContextPool::Lease::init(const unsigned char key[ECC_AES_KEY_SIZE / 8],
+                                               const unsigned char nonce[ECC_AES_GCM_IV_SIZE], bool encrypt) {
+    const int mode = encrypt ? 1 : 2;
+    const bool keyed = entry_->mode == mode && CRYPTO_memcmp(entry_->key, key, sizeof(entry_->key)) == 0;
+    const int ok = EVP_CipherInit_ex(entry_->ctx, entry_->bound ? nullptr : EVP_aes_256_gcm(), nullptr,
+                                     keyed ? nullptr : key, nonce, encrypt ? 1 : 0);
+    if (ok != 1) {
+        OPENSSL_cleanse(entry_->key, sizeof(entry_->key));
+        entry_->mode = 0;
+        entry_->bound = false;
+        throw std::runtime_error("Error initializing cipher context.");
+    }
+    entry_->bound = true;
+    if (!keyed) {
+        std::memcpy(entry_->key, key, sizeof(entry_->key));
+        entry_->mode = mode;
+    }
+    return entry_->ctx;
+}
+
+SegmentCipher::SegmentCipher(const unsigned char* key, const ContainerHeader& header)
+    : lease_(CipherContextPool::acquire()), key_(key), header_(header), aad_(header.serialize()) {}
+
+void SegmentCipher::makeNonce(uint64_t index, bool last, unsigned char nonce[ECC_AES_GCM_IV_SIZE]) const {
+    std::memcpy(nonce, header_.nonce_prefix, ECC_AES_NONCE_PREFIX_SIZE);
+    nonce[7] = static_cast<unsigned char>(index >> 24);
+    nonce[8] = static_cast<unsigned char>(index >> 16);
+    nonce[9] = static_cast<unsigned char>(index >> 8);
+    nonce[10] = static_cast<unsigned char>(index);
+    nonce[11] = last ? 1 : 0;
+}
+
+void SegmentCipher::seal(uint64_t index, bool last, const unsigned char* in, size_t len, unsigned char* out) {
+    unsigned char nonce[ECC_AES_GCM_IV_SIZE];
+    makeNonce(index, last, nonce);
+    EVP_CIPHER_CTX* ctx = lease_.init(key_, nonce, true);
+    int out_len = 0;
+    if (EVP_EncryptUpdate(ctx, nullptr, &out_len, aad_.data(), static_cast<int>(aad_.size())) != 1 ||
+        EVP_EncryptUpdate(ctx, out, &out_len, in, static_cast<int>(len)) != 1 ||
+        EVP_EncryptFinal_ex(ctx, out + out_len, &out_len) != 1 ||
+        EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, ECC_AES_GCM_TAG_SIZE, out + len) != 1) {
+        throw std::runtime_error("Error encrypting segment.");
+    }
+}
+
+void SegmentCipher::open(uint64_t index, bool last, const unsigned char* in, size_t len, unsigned char* out) {
+    unsigned char nonce[ECC_AES_GCM_IV_SIZE];
+    makeNonce(index, last, nonce);
+    unsigned char tag[ECC_AES_GCM_TAG_SIZE];
+    std::memcpy(tag, in + len, ECC_AES_GCM_TAG_SIZE);
+    EVP_CIPHER_CTX* ctx = lease_.init(key_, nonce, false);
+    int out_len = 0;
+    if (EVP_DecryptUpdate(ctx, nullptr, &out_len, aad_.data(), static_cast<int>(aad_.size())) != 1 ||
+        EVP_DecryptUpdate(ctx, out, &out_len, in, static_cast<int>(len)) != 1 ||
+        EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, ECC_AES_GCM_TAG_SIZE, tag) != 1 ||
+        EVP_DecryptFinal_ex(ctx, out + out_len, &out_len) != 1) {
+        throw std::runtime_error("Segment " + std::to_string(index) +
+                                 " failed authentication (corrupted, truncated or reordered).");
+    }
+}
+
+namespace {
+
+// 常驻工作线程池。线程在第一次需要时创建并一直存活到进程结束，
+// 这样各线程的 CipherContextPool 在多次调用之间得以保留，不会随线程退出而释放。
+// 多个调用方可以同时提交任务：任务进入共享队列，空闲的工作线程按先后顺序加入任务，
+// 调用方自己也参与执行自己的任务，因此并发的调用方不会相互串行等待。
+class WorkerPool {
+public:
+    static WorkerPool& instance() {
+        static WorkerPool pool;
+        return pool;
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (auto& t : threads_) {
+            t.join();
+        }
+    }
+
+    // 在调用线程上以 id 0 执行 job，并让最多 workers - 1 个工作线程以 id 1.. 加入执行，
+    // 所有加入的线程都返回后才返回。调用方完成时仍未被领取的 id 不再执行，
+    // 因此 job 应自行分配工作（例如共享的原子计数器）。job 不能抛出异常。
+    void run(unsigned int workers, const std::function<void(unsigned int)>& job) {
+        if (workers <= 1) {
+            job(0);
+            return;
+        }
+        Task task{&job, 1, workers, 0};
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            while (threads_.size() + 1 < workers) {
+                threads_.emplace_back(&WorkerPool::loop, this);
+            }
+            queue_.push_back(&task);
+        }
+        wake_.notify_all();
+        job(0);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        const auto queued = std::find(queue_.begin(), queue_.end(), &task);
+        if (queued != queue_.end()) {
+            queue_.erase(queued);
+        }
+        done_.wait(lock, [&task] { return task.running == 0; });
+    }
+
+private:
+    struct Task {
+        const std::function<void(unsigned int)>* job;
+        unsigned int next_id;
+        unsigned int workers;
+        unsigned int running;
+    };
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    std::vector<std::thread> threads_;
+    std::deque<Task*> queue_;
+    bool stopping_ = false;
+
+    WorkerPool() = default;
+
+    void loop() {
+        AIK_TRACE_THREAD_NAME("segment_worker");
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            wake_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            Task* task = queue_.front();
+            const unsigned int id = task->next_id++;
+            if (task->next_id == task->workers) {
+                queue_.pop_front();
+            }
+            ++task->running;
+            lock.unlock();
+            (*task->job)(id);
+            lock.lock();
+            if (--task->running == 0) {
+                done_.notify_all();
+            }
+        }
+    }
+};
+
+} // namespace
+
+// 将 [0, count) 的段分给常驻线程池处理，每个线程持有自己的 SegmentCipher；
+// 只有一个线程时直接在调用线程上执行
+template <typename Fn>
+static void forEachSegment(const ContainerHeader& header, const unsigned char* key, size_t count,
+                           unsigned int threads, Fn fn) {
+    const unsigned int workers = static_cast<unsigned int>(std::max<size_t>(1, std::min<size_t>(threads, count)));
+    if (workers == 1) {
+        SegmentCipher cipher(key, header);
+        for (size_t i = 0; i < count; ++i) {
+            fn(cipher, i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    std::vector<std::string> errors(workers);
+    WorkerPool::instance().run(workers, [&](unsigned int id) {
+        try {
+            SegmentCipher cipher(key, header);
+            for (size_t i = next++; i < count; i = next++) {
+                fn(cipher, i);
+            }
+        } catch (const std::exception& e) {
+            errors[id] = e.what();
+            next = count;
+        }
+    });
+    for (const auto& error : errors) {
+        if (!error.empty()) {
+            throw std::runtime_error(error);
+        }
+    }
+}
+
+void sealSegments(const ContainerHeader& header, const unsigned char* key, uint64_t first_index,
+                  uint64_t segment_count, ByteSpan plaintext, MutableByteSpan out, unsigned int threads) {
+    const size_t segment_size = header.segment_size;
+    const size_t stored_size = segment_size + ECC_AES_GCM_TAG_SIZE;
+    const size_t count = std::max<size_t>(1, (plaintext.size + segment_size - 1) / segment_size);
+    if (out.size < plaintext.size + count * ECC_AES_GCM_TAG_SIZE) {
+        throw std::runtime_error("Output buffer too small.");
+    }
+
+    AIK_TRACE_SCOPE("sealSegments");
+    AIK_TRACE_COUNTER("segments_per_batch", count);
+    forEachSegment(header, key, count, threads, [&](SegmentCipher& cipher, size_t i) {
+        AIK_TRACE_SCOPE("seal_segment");
+        const size_t len = std::min(segment_size, plaintext.size - std::min(plaintext.size, i * segment_size));
+        cipher.seal(first_index + i, first_index + i == segment_count - 1, plaintext.data + i * segment_size, len,
+                    out.data + i * stored_size);
+    });
+}
+
+size_t openSegments(const ContainerHeader& header, const unsigned char* key, uint64_t first_index,
+                    uint64_t segment_count, ByteSpan ciphertext, MutableByteSpan out, unsigned int threads) {
+    const size_t segment_size = header.segment_size;
+    const size_t stored_size = segment_size + ECC_AES_GCM_TAG_SIZE;
+    const size_t count = (ciphertext.size + stored_size - 1) / stored_size;
+    if (count == 0 || ciphertext.size - (count - 1) * stored_size < ECC_AES_GCM_TAG_SIZE) {
+        throw std::runtime_error("Encrypted data is truncated.");
+    }
+    const size_t plaintext_size = ciphertext.size - count * ECC_AES_GCM_TAG_SIZE;
+    if (out.size < plaintext_size) {
+        throw std::runtime_error("Output buffer too small.");
+    }
+
+    AIK_TRACE_SCOPE("openSegments");
+    AIK_TRACE_COUNTER("segments_per_batch", count);
+    forEachSegment(header, key, count, threads, [&](SegmentCipher& cipher, size_t i) {
+        AIK_TRACE_SCOPE("open_segment");
+        const size_t len = std::min(stored_size, ciphertext.size - i * stored_size) - ECC_AES_GCM_TAG_SIZE;
+        cipher.open(first_index + i, first_index + i == segment_count - 1, ciphertext.data + i * stored_size, len,
+                    out.data + i * segment_size);
+    });
+    return plaintext_size;
+}
+
+static std::string opensslError(const std::string& message) {
+    unsigned long code = ERR_get_error();
+    if (code == 0) {
+        return message;
+    }
+    char buffer[256];
+    ERR_error_string_n(code, buffer, sizeof(buffer));
+    return message + " (" + buffer + ")";
+}
+
+static unsigned char kemOf(EVP_PKEY* pkey) {
+    if (EVP_PKEY_id(pkey) == EVP_PKEY_X25519) {
+        return ECC_AES_KEM_X25519;
+    }
+    if (EVP_PKEY_id(pkey) == EVP_PKEY_EC) {
+        char group[64];
+        size_t group_len = 0;
+        if (EVP_PKEY_get_utf8_string_param(pkey, OSSL_PKEY_PARAM_GROUP_NAME, group, sizeof(group), &group_len) == 1 &&
+            std::strcmp(group, "prime256v1") == 0) {
+            return ECC_AES_KEM_P256;
+        }
+    }
+    throw std::runtime_error("Key must be X25519 or P-256.");
+}
+
+static std::vector<unsigned char> encodedPublicKey(EVP_PKEY* pkey) {
+    unsigned char* encoded = nullptr;
+    size_t len = EVP_PKEY_get1_encoded_public_key(pkey, &encoded);
+    if (len == 0) {
+        throw std::runtime_error(opensslError("Error encoding public key."));
+    }
+    std::vector<unsigned char> out(encoded, encoded + len);
+    OPENSSL_free(encoded);
+    return out;
+}
+
+// ECDH 共享秘密 -> HKDF-SHA256 -> KEK，salt 绑定临时公钥和接收方公钥
+static void deriveKEK(EVP_PKEY* own, EVP_PKEY* peer, bool validate_peer,
+                      const std::vector<unsigned char>& ephemeral_public,
+                      const std::vector<unsigned char>& recipient_public, unsigned char kek[ECC_AES_KEY_SIZE / 8]) {
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new(own, nullptr);
+    std::vector<unsigned char> secret;
+    size_t secret_len = 0;
+    bool ok = ctx != nullptr && EVP_PKEY_derive_init(ctx) == 1 &&
+              EVP_PKEY_derive_set_peer_ex(ctx, peer, validate_peer ? 1 : 0) == 1 &&
+              EVP_PKEY_derive(ctx, nullptr, &secret_len) == 1;
+    if (ok) {
+        secret.resize(secret_len);
+        ok = EVP_PKEY_derive(ctx, secret.data(), &secret_len) == 1;
+    }
+    EVP_PKEY_CTX_free(ctx);
+    if (!ok) {
+        throw std::runtime_error(opensslError("Error deriving ECDH shared secret."));
+    }
+
+    std::vector<unsigned char> salt(ephemeral_public);
+    salt.insert(salt.end(), recipient_public.begin(), recipient_public.end());
+    ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, nullptr);
+    size_t kek_len = ECC_AES_KEY_SIZE / 8;
+    ok = ctx != nullptr && EVP_PKEY_derive_init(ctx) == 1 &&
+         EVP_PKEY_CTX_set_hkdf_md(ctx, EVP_sha256()) == 1 &&
+         EVP_PKEY_CTX_set1_hkdf_salt(ctx, salt.data(), static_cast<int>(salt.size())) == 1 &&
+         EVP_PKEY_CTX_set1_hkdf_key(ctx, secret.data(), static_cast<int>(secret_len)) == 1 &&
+         EVP_PKEY_CTX_add1_hkdf_info(ctx, reinterpret_cast<const unsigned char*>(KEK_INFO),
+                                     static_cast<int>(sizeof(KEK_INFO) - 1)) == 1 &&
+         EVP_PKEY_derive(ctx, kek, &kek_len) == 1;
+    EVP_PKEY_CTX_free(ctx);
+    OPENSSL_cleanse(secret.data(), secret.size());
+    if (!ok) {
+        throw std::runtime_error(opensslError("Error deriving key-encryption key."));
+    }
+}
+
+// 用 KEK 包装/解包数据密钥，AAD 为 header 中包装密钥之前的全部字节
+static void wrapDataKey(const unsigned char kek[ECC_AES_KEY_SIZE / 8],
+                        const unsigned char data_key[ECC_AES_KEY_SIZE / 8], ContainerHeader& header) {
+    const std::vector<unsigned char> aad = header.serializePrefix();
+    const unsigned char nonce[ECC_AES_GCM_IV_SIZE] = {0};
+    CipherContextPool::Lease lease = CipherContextPool::acquire();
+    EVP_CIPHER_CTX* ctx = lease.init(kek, nonce, true);
+    int len = 0;
+    if (EVP_EncryptUpdate(ctx, nullptr, &len, aad.data(), static_cast<int>(aad.size())) != 1 ||
+        EVP_EncryptUpdate(ctx, header.wrapped_key, &len, data_key, ECC_AES_KEY_SIZE / 8) != 1 ||
+        EVP_EncryptFinal_ex(ctx, header.wrapped_key + len, &len) != 1 ||
+        EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, ECC_AES_GCM_TAG_SIZE,
+                            header.wrapped_key + ECC_AES_KEY_SIZE / 8) != 1) {
+        throw std::runtime_error("Error wrapping data key.");
+    }
+}
+
+static void unwrapDataKey(const unsigned char kek[ECC_AES_KEY_SIZE / 8], const ContainerHeader& header,
+                          unsigned char data_key[ECC_AES_KEY_SIZE / 8]) {
+    const std::vector<unsigned char> aad = header.serializePrefix();
+    const unsigned char nonce[ECC_AES_GCM_IV_SIZE] = {0};
+    unsigned char tag[ECC_AES_GCM_TAG_SIZE];
+    std::memcpy(tag, header.wrapped_key + ECC_AES_KEY_SIZE / 8, ECC_AES_GCM_TAG_SIZE);
+    CipherContextPool::Lease lease = CipherContextPool::acquire();
+    EVP_CIPHER_CTX* ctx = lease.init(kek, nonce, false);
+    int len = 0;
+    if (EVP_DecryptUpdate(ctx, nullptr, &len, aad.data(), static_cast<int>(aad.size())) != 1 ||
+        EVP_DecryptUpdate(ctx, data_key, &len, header.wrapped_key, ECC_AES_KEY_SIZE / 8) != 1 ||
+        EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, ECC_AES_GCM_TAG_SIZE, tag) != 1 ||
+        EVP_DecryptFinal_ex(ctx, data_key + len, &len) != 1) {
+        OPENSSL_cleanse(data_key, ECC_AES_KEY_SIZE / 8);
+        throw std::runtime_error("Unable to unwrap data key (wrong private key or corrupted header).");
+    }
+}
+
+static EVP_PKEY* readPemKey(ByteSpan pem, bool private_key) {
+    BIO* bio = BIO_new_mem_buf(pem.data, static_cast<int>(pem.size));
+    if (bio == nullptr) {
+        throw std::runtime_error("Error allocating key buffer.");
+    }
+    EVP_PKEY* pkey = private_key ? PEM_read_bio_PrivateKey(bio, nullptr, nullptr, nullptr)
+                                 : PEM_read_bio_PUBKEY(bio, nullptr, nullptr, nullptr);
+    BIO_free(bio);
+    if (pkey == nullptr) {
+        throw std::runtime_error(opensslError(private_key ? "Error parsing private key." : "Error parsing public key."));
+    }
+    return pkey;
+}
+
+RecipientKey::RecipientKey(ByteSpan public_key_pem) : pkey_(readPemKey(public_key_pem, false)), keygen_ctx_(nullptr) {
+    try {
+        kem_ = kemOf(pkey_);
+        encoded_ = encodedPublicKey(pkey_);
+
+        // 公钥点校验只在这里做一次，派生共享秘密时跳过
+        EVP_PKEY_CTX* check = EVP_PKEY_CTX_new(pkey_, nullptr);
+        bool valid = check != nullptr && EVP_PKEY_public_check(check) == 1;
+        EVP_PKEY_CTX_free(check);
+        if (!valid) {
+            throw std::runtime_error(opensslError("Recipient public key failed validation."));
+        }
+
+        keygen_ctx_ = EVP_PKEY_CTX_new(pkey_, nullptr);
+        if (keygen_ctx_ == nullptr || EVP_PKEY_keygen_init(keygen_ctx_) != 1) {
+            throw std::runtime_error(opensslError("Error preparing ephemeral key generation."));
+        }
+    } catch (...) {
+        EVP_PKEY_CTX_free(keygen_ctx_);
+        EVP_PKEY_free(pkey_);
+        throw;
+    }
+}
+
+RecipientKey::~RecipientKey() {
+    EVP_PKEY_CTX_free(keygen_ctx_);
+    EVP_PKEY_free(pkey_);
+}
+
+void RecipientKey::wrap(const unsigned char data_key[ECC_AES_KEY_SIZE / 8], ContainerHeader& header) {
+    AIK_TRACE_SCOPE("wrap_data_key");
+    EVP_PKEY* ephemeral = nullptr;
+    if (EVP_PKEY_keygen(keygen_ctx_, &ephemeral) != 1) {
+        throw std::runtime_error(opensslError("Error generating ephemeral key."));
+    }
+    unsigned char kek[ECC_AES_KEY_SIZE / 8];
+    try {
+        header.kem = kem_;
+        header.ephemeral_public = encodedPublicKey(ephemeral);
+        deriveKEK(ephemeral, pkey_, false, header.ephemeral_public, encoded_, kek);
+        wrapDataKey(kek, data_key, header);
+    } catch (...) {
+        OPENSSL_cleanse(kek, sizeof(kek));
+        EVP_PKEY_free(ephemeral);
+        throw;
+    }
+    OPENSSL_cleanse(kek, sizeof(kek));
+    EVP_PKEY_free(ephemeral);
+}
+
+RecipientPrivateKey::RecipientPrivateKey(ByteSpan private_key_pem) : pkey_(readPemKey(private_key_pem, true)) {
+    try {
+        kem_ = kemOf(pkey_);
+        encoded_ = encodedPublicKey(pkey_);
+    } catch (...) {
+        EVP_PKEY_free(pkey_);
+        throw;
+    }
+}
+
+RecipientPrivateKey::~RecipientPrivateKey() {
+    EVP_PKEY_free(pkey_);
+}
+
+EVP_PKEY* RecipientPrivateKey::ephemeralFrom(const ContainerHeader& header) const {
+    const std::vector<unsigned char>& pub = header.ephemeral_public;
+    EVP_PKEY* peer = nullptr;
+    if (header.kem == ECC_AES_KEM_X25519) {
+        peer = EVP_PKEY_new_raw_public_key(EVP_PKEY_X25519, nullptr, pub.data(), pub.size());
+    } else {
+        peer = EVP_PKEY_new();
+        if (peer != nullptr && (EVP_PKEY_copy_parameters(peer, pkey_) != 1 ||
+                                EVP_PKEY_set1_encoded_public_key(peer, pub.data(), pub.size()) != 1)) {
+            EVP_PKEY_free(peer);
+            peer = nullptr;
+        }
+    }
+    if (peer == nullptr) {
+        throw std::runtime_error(opensslError("Invalid ephemeral public key in header."));
+    }
+    return peer;
+}
+
+void RecipientPrivateKey::unwrap(const ContainerHeader& header, unsigned char data_key[ECC_AES_KEY_SIZE / 8]) const {
+    AIK_TRACE_SCOPE("unwrap_data_key");
+    if (header.kem != kem_) {
+        throw std::runtime_error("Private key type does not match the encrypted data.");
+    }
+    EVP_PKEY* peer = ephemeralFrom(header);
+    unsigned char kek[ECC_AES_KEY_SIZE / 8];
+    try {
+        // 临时公钥来自不可信的输入，必须校验
+        deriveKEK(pkey_, peer, true, header.ephemeral_public, encoded_, kek);
+        unwrapDataKey(kek, header, data_key);
+    } catch (...) {
+        OPENSSL_cleanse(kek, sizeof(kek));
+        EVP_PKEY_free(peer);
+        throw;
+    }
+    OPENSSL_cleanse(kek, sizeof(kek));
+    EVP_PKEY_free(peer);
+}
+
+ContainerHeader newContainerHeader(RecipientKey& recipient, uint32_t segment_size,
+                                   unsigned char data_key[ECC_AES_KEY_SIZE / 8]) {
+    if (segment_size == 0 || segment_size > ECC_AES_MAX_SEGMENT_SIZE) {
+        throw std::invalid_argument("Segment size must be between 1 and " +
+                                    std::to_string(ECC_AES_MAX_SEGMENT_SIZE) + ".");
+    }
+    ContainerHeader header;
+    header.segment_size = segment_size;
+    if (RAND_bytes(data_key, ECC_AES_KEY_SIZE / 8) != 1) {
+        throw std::runtime_error("Error generating AES key.");
+    }
+    if (RAND_bytes(header.nonce_prefix, sizeof(header.nonce_prefix)) != 1) {
+        throw std::runtime_error("Error generating nonce prefix.");
+    }
+    recipient.wrap(data_key, header);
+    return header;
+}
+
+EnvelopeSealer::EnvelopeSealer(RecipientKey& recipient, uint32_t segment_size, unsigned int threads)
+    : recipient_(recipient), segment_size_(segment_size), threads_(std::max(1u, threads)) {
+    if (segment_size_ == 0 || segment_size_ > ECC_AES_MAX_SEGMENT_SIZE) {
+        throw std::invalid_argument("Segment size must be between 1 and " +
+                                    std::to_string(ECC_AES_MAX_SEGMENT_SIZE) + ".");
+    }
+}
+
+size_t EnvelopeSealer::sealedSize(size_t plaintext_size) const {
+    const size_t segment_count = std::max<size_t>(1, (plaintext_size + segment_size_ - 1) / segment_size_);
+    return ECC_AES_CONTAINER_FIXED_HEADER_SIZE + kemPublicSize(recipient_.kem()) + ECC_AES_WRAPPED_KEY_SIZE +
+           plaintext_size + segment_count * ECC_AES_GCM_TAG_SIZE;
+}
+
+size_t EnvelopeSealer::seal(ByteSpan plaintext, MutableByteSpan out) {
+    const size_t sealed_size = sealedSize(plaintext.size);
+    if (out.size < sealed_size) {
+        throw std::runtime_error("Output buffer too small.");
+    }
+    unsigned char key[ECC_AES_KEY_SIZE / 8];
+    try {
+        const ContainerHeader header = newContainerHeader(recipient_, segment_size_, key);
+        const ContainerLayout layout = ContainerLayout::forPlaintext(header, plaintext.size);
+        const std::vector<unsigned char> header_bytes = header.serialize();
+        std::memcpy(out.data, header_bytes.data(), header_bytes.size());
+        sealSegments(header, key, 0, layout.segment_count, plaintext,
+                     MutableByteSpan(out.data + header_bytes.size(), out.size - header_bytes.size()), threads_);
+    } catch (...) {
+        OPENSSL_cleanse(key, sizeof(key));
+        throw;
+    }
+    OPENSSL_cleanse(key, sizeof(key));
+    return sealed_size;
+}
+
+std::vector<unsigned char> EnvelopeSealer::seal(ByteSpan plaintext) {
+    std::vector<unsigned char> out(sealedSize(plaintext.size));
+    seal(plaintext, MutableByteSpan(out));
+    return out;
+}
+
+EnvelopeOpener::EnvelopeOpener(const RecipientPrivateKey& key, unsigned int threads)
+    : key_(key), threads_(std::max(1u, threads)) {}
+
+uint64_t EnvelopeOpener::plaintextSize(ByteSpan sealed) const {
+    return ContainerLayout::forContainer(ContainerHeader::parse(sealed), sealed.size).plaintext_size;
+}
+
+size_t EnvelopeOpener::open(ByteSpan sealed, MutableByteSpan out) {
+    const ContainerHeader header = ContainerHeader::parse(sealed);
+    const ContainerLayout layout = ContainerLayout::forContainer(header, sealed.size);
+    if (out.size < layout.plaintext_size) {
+        throw std::runtime_error("Output buffer too small.");
+    }
+    unsigned char key[ECC_AES_KEY_SIZE / 8];
+    key_.unwrap(header, key);
+    try {
+        openSegments(header, key, 0, layout.segment_count,
+                     ByteSpan(sealed.data + layout.header_size, sealed.size - layout.header_size), out, threads_);
+    } catch (...) {
+        OPENSSL_cleanse(key, sizeof(key));
+        throw;
+    }
+    OPENSSL_cleanse(key, sizeof(key));
+    return static_cast<size_t>(layout.plaintext_size);
+}
+
+std::vector<unsigned char> EnvelopeOpener::open(ByteSpan sealed) {
+    std::vector<unsigned char> out(static_cast<size_t>(plaintextSize(sealed)));
+    open(sealed, MutableByteSpan(out));
+    return out;
+}
+
+size_t EnvelopeOpener::openRange(ByteSpan sealed, uint64_t offset, uint64_t length, MutableByteSpan out) {
+    const ContainerHeader header = ContainerHeader::parse(sealed);
+    const ContainerLayout layout = ContainerLayout::forContainer(header, sealed.size);
+    if (offset > layout.plaintext_size || length > layout.plaintext_size - offset) {
+        throw std::runtime_error("Requested range exceeds plaintext size " + std::to_string(layout.plaintext_size) +
+                                 ".");
+    }
+    if (out.size < length) {
+        throw std::runtime_error("Output buffer too small.");
+    }
+    if (length == 0) {
+        return 0;
+    }
+
+    const uint64_t first = offset / header.segment_size;
+    const uint64_t end = (offset + length - 1) / header.segment_size + 1;
+    const uint64_t stored_begin = layout.header_size + first * layout.stored_segment_size;
+    const uint64_t stored_end = std::min<uint64_t>(sealed.size, layout.header_size + end * layout.stored_segment_size);
+    // 按实际存在的密文字节数分配，不按 header 中的 segment_size；明文总比对应的密文短
+    std::vector<unsigned char> plaintext(static_cast<size_t>(stored_end - stored_begin));
+
+    unsigned char key[ECC_AES_KEY_SIZE / 8];
+    key_.unwrap(header, key);
+    try {
+        openSegments(header, key, first, layout.segment_count,
+                     ByteSpan(sealed.data + stored_begin, static_cast<size_t>(stored_end - stored_begin)),
+                     MutableByteSpan(plaintext), threads_);
+    } catch (...) {
+        OPENSSL_cleanse(key, sizeof(key));
+        throw;
+    }
+    OPENSSL_cleanse(key, sizeof(key));
+    std::memcpy(out.data, plaintext.data() + (offset - first * header.segment_size), static_cast<size_t>(length));
+    return static_cast<size_t>(length);
+}
+
+SealStream::SealStream(RecipientKey& recipient, uint32_t segment_size)
+    : header_(newContainerHeader(recipient, segment_size, key_)), cipher_(new SegmentCipher(key_, header_)), next_index_(0),
+      header_written_(false), finished_(false) {
+    pending_.reserve(segment_size);
+}
+
+SealStream::~SealStream() {
+    OPENSSL_cleanse(key_, sizeof(key_));
+}
+
+void SealStream::writeHeader(std::vector<unsigned char>& out) {
+    if (!header_written_) {
+        const std::vector<unsigned char> header_bytes = header_.serialize();
+        out.insert(out.end(), header_bytes.begin(), header_bytes.end());
+        header_written_ = true;
+    }
+}
+
+void SealStream::sealSegment(const unsigned char* in, size_t len, bool last, std::vector<unsigned char>& out) {
+    if (next_index_ > UINT32_MAX) {
+        throw std::runtime_error("Input too large for container format.");
+    }
+    const size_t pos = out.size();
+    out.resize(pos + len + ECC_AES_GCM_TAG_SIZE);
+    cipher_->seal(next_index_++, last, in, len, out.data() + pos);
+}
+
+void SealStream::update(ByteSpan plaintext, std::vector<unsigned char>& out) {
+    if (finished_) {
+        throw std::logic_error("SealStream::update called after finish.");
+    }
+    writeHeader(out);
+
+    // 始终保留至少一个字节未加密，直到确认后面还有数据时才能确定一段不是最后一段
+    const size_t segment_size = header_.segment_size;
+    size_t pos = 0;
+    while (pos < plaintext.size) {
+        if (pending_.size() == segment_size) {
+            sealSegment(pending_.data(), pending_.size(), false, out);
+            pending_.clear();
+        }
+        if (pending_.empty()) {
+            while (plaintext.size - pos > segment_size) {
+                sealSegment(plaintext.data + pos, segment_size, false, out);
+                pos += segment_size;
+            }
+        }
+        const size_t take = std::min(segment_size - pending_.size(), plaintext.size - pos);
+        pending_.insert(pending_.end(), plaintext.data + pos, plaintext.data + pos + take);
+        pos += take;
+    }
+}
+
+void SealStream::finish(std::vector<unsigned char>& out) {
+    if (finished_) {
+        throw std::logic_error("SealStream::finish called twice.");
+    }
+    writeHeader(out);
+    sealSegment(pending_.data(), pending_.size(), true, out);
+    OPENSSL_cleanse(pending_.data(), pending_.size());
+    pending_.clear();
+    finished_ = true;
+}
+
+OpenStream::OpenStream(const RecipientPrivateKey& key) : private_key_(key), next_index_(0), finished_(false) {}
+
+OpenStream::~OpenStream() {
+    OPENSSL_cleanse(key_, sizeof(key_));
+}
+
+void OpenStream::parseHeader(ByteSpan sealed, size_t& pos) {
+    // 先凑齐固定部分以得知 header 全长，再凑齐剩余部分
+    size_t needed = ECC_AES_CONTAINER_FIXED_HEADER_SIZE;
+    while (pos < sealed.size) {
+        if (header_bytes_.size() >= ECC_AES_CONTAINER_FIXED_HEADER_SIZE) {
+            needed = ECC_AES_CONTAINER_FIXED_HEADER_SIZE + kemPublicSize(header_bytes_[5]) + ECC_AES_WRAPPED_KEY_SIZE;
+        }
+        if (header_bytes_.size() == needed) {
+            break;
+        }
+        const size_t take = std::min(needed - header_bytes_.size(), sealed.size - pos);
+        header_bytes_.insert(header_bytes_.end(), sealed.data + pos, sealed.data + pos + take);
+        pos += take;
+    }
+    if (header_bytes_.size() >= ECC_AES_CONTAINER_FIXED_HEADER_SIZE &&
+        header_bytes_.size() ==
+            ECC_AES_CONTAINER_FIXED_HEADER_SIZE + kemPublicSize(header_bytes_[5]) + ECC_AES_WRAPPED_KEY_SIZE) {
+        header_ = ContainerHeader::parse(ByteSpan(header_bytes_));
+        private_key_.unwrap(header_, key_);
+        cipher_.reset(new SegmentCipher(key_, header_));
+    }
+}
+
+void OpenStream::openSegment(const unsigned char* in, size_t len, bool last, std::vector<unsigned char>& out) {
+    if (next_index_ > UINT32_MAX) {
+        throw std::runtime_error("Encrypted data has too many segments.");
+    }
+    const size_t plaintext_len = len - ECC_AES_GCM_TAG_SIZE;
+    const size_t pos = out.size();
+    out.resize(pos + plaintext_len);
+    try {
+        cipher_->open(next_index_++, last, in, plaintext_len, out.data() + pos);
+    } catch (...) {
+        out.resize(pos);
+        throw;
+    }
+}
+
+void OpenStream::update(ByteSpan sealed, std::vector<unsigned char>& out) {
+    if (finished_) {
+        throw std::logic_error("OpenStream::update called after finish.");
+    }
+    size_t pos = 0;
+    if (!cipher_) {
+        parseHeader(sealed, pos);
+        if (!cipher_) {
+            return;
+        }
+    }
+
+    // 与 SealStream 相同，保留最后一个已存储段直到 finish() 以校验 last_flag。
+    // pending_ 随实际输入增长，不按 header 中的 segment_size 预先分配
+    const size_t stored_size = header_.segment_size + ECC_AES_GCM_TAG_SIZE;
+    while (pos < sealed.size) {
+        if (pending_.size() == stored_size) {
+            openSegment(pending_.data(), pending_.size(), false, out);
+            pending_.clear();
+        }
+        if (pending_.empty()) {
+            while (sealed.size - pos > stored_size) {
+                openSegment(sealed.data + pos, stored_size, false, out);
+                pos += stored_size;
+            }
+        }
+        const size_t take = std::min(stored_size - pending_.size(), sealed.size - pos);
+        pending_.insert(pending_.end(), sealed.data + pos, sealed.data + pos + take);
+        pos += take;
+    }
+}
+
+void OpenStream::finish(std::vector<unsigned char>& out) {
+    if (finished_) {
+        throw std::logic_error("OpenStream::finish called twice.");
+    }
+    if (!cipher_ || pending_.size() < ECC_AES_GCM_TAG_SIZE) {
+        throw std::runtime_error("Encrypted data is truncated.");
+    }
+    openSegment(pending_.data(), pending_.size(), true, out);
+    pending_.clear();
+    finished_ = true;
+}
+
+} // namespace ecc_aes
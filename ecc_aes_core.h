@@ -0,0 +1,242 @@
+#ifndef ECC_AES_CORE_H
+#define ECC_AES_CORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <openssl/evp.h>
+
+// 本头文件会被安装给其它程序使用：宏统一加 ECC_AES_ 前缀，类型和函数都在 ecc_aes 命名空间中，
+// 以免与 OpenSSL 等头文件或使用方的代码冲突。段加解密器、上下文池等内部实现见 ecc_aes_internal.h（不安装）
+#define ECC_AES_KEY_SIZE 256
+
+// 分段 AEAD 容器格式 (STREAM 构造)
+//
+//   header:
+//     magic "EAES" | version u8 | kem u8 | reserved[2] | segment_size u32 (大端) | nonce_prefix[7] | reserved u8
+//     ephemeral_public (X25519: 32 字节, P-256: 65 字节未压缩点) | wrapped_key[32] | wrap_tag[16]
+//   segments:
+//     每段为 AES-256-GCM(plaintext) || tag(16)，除最后一段外明文长度均为 segment_size
+//
+// 保留字节必须为 0，解析时拒绝非零值，因此重建出的 header 与文件中的字节完全一致。
+// 第 i 段的 nonce = nonce_prefix || BE32(i) || last_flag，整个 header 作为每段的 AAD。
+// 计数器防止段被重排，last_flag 防止在段边界处截断，各段相互独立因而可以并行处理和随机访问。
+//
+// 数据密钥采用信封加密：临时密钥与接收方公钥做 ECDH，经 HKDF-SHA256 得到 KEK，
+// 再用 AES-256-GCM 包装数据密钥。每个文件的 KEK 都不同，因此包装时使用全零 nonce。
+#define ECC_AES_CONTAINER_VERSION 2
+#define ECC_AES_CONTAINER_FIXED_HEADER_SIZE 20
+#define ECC_AES_DEFAULT_SEGMENT_SIZE (64 * 1024)
+// segment_size 来自不可信的 header，解密时按它分配缓冲区，因此设上限
+#define ECC_AES_MAX_SEGMENT_SIZE (16 * 1024 * 1024)
+#define ECC_AES_GCM_IV_SIZE 12
+#define ECC_AES_GCM_TAG_SIZE 16
+#define ECC_AES_NONCE_PREFIX_SIZE 7
+
+#define ECC_AES_KEM_X25519 1
+#define ECC_AES_KEM_P256 2
+#define ECC_AES_X25519_PUBLIC_SIZE 32
+#define ECC_AES_P256_PUBLIC_SIZE 65
+#define ECC_AES_WRAPPED_KEY_SIZE (ECC_AES_KEY_SIZE / 8 + ECC_AES_GCM_TAG_SIZE)
+#define ECC_AES_MAX_CONTAINER_HEADER_SIZE \
+    (ECC_AES_CONTAINER_FIXED_HEADER_SIZE + ECC_AES_P256_PUBLIC_SIZE + ECC_AES_WRAPPED_KEY_SIZE)
+
+namespace ecc_aes {
+
+// 只读/可写的连续字节区间，调用方持有内存
+struct ByteSpan {
+    const unsigned char* data;
+    size_t size;
+
+    ByteSpan() : data(nullptr), size(0) {}
+    ByteSpan(const unsigned char* d, size_t n) : data(d), size(n) {}
+    ByteSpan(const std::vector<unsigned char>& v) : data(v.data()), size(v.size()) {}
+    ByteSpan(const std::string& s) : data(reinterpret_cast<const unsigned char*>(s.data())), size(s.size()) {}
+};
+
+struct MutableByteSpan {
+    unsigned char* data;
+    size_t size;
+
+    MutableByteSpan() : data(nullptr), size(0) {}
+    MutableByteSpan(unsigned char* d, size_t n) : data(d), size(n) {}
+    MutableByteSpan(std::vector<unsigned char>& v) : data(v.data()), size(v.size()) {}
+};
+
+size_t kemPublicSize(unsigned char kem);
+
+struct ContainerHeader {
+    unsigned char kem;
+    uint32_t segment_size;
+    unsigned char nonce_prefix[ECC_AES_NONCE_PREFIX_SIZE];
+    std::vector<unsigned char> ephemeral_public;
+    unsigned char wrapped_key[ECC_AES_WRAPPED_KEY_SIZE];
+
+    size_t size() const;
+
+    // 固定部分加临时公钥，作为包装数据密钥时的 AAD
+    std::vector<unsigned char> serializePrefix() const;
+    std::vector<unsigned char> serialize() const;
+
+    // in 不足一个完整 header 或 segment_size 超出 (0, ECC_AES_MAX_SEGMENT_SIZE] 时抛出异常
+    static ContainerHeader parse(ByteSpan in);
+};
+
+// 由 header 和容器总长度推出的段布局
+struct ContainerLayout {
+    uint64_t header_size;
+    uint64_t stored_segment_size;
+    uint64_t segment_count;
+    uint64_t plaintext_size;
+
+    static ContainerLayout forPlaintext(const ContainerHeader& header, uint64_t plaintext_size);
+    static ContainerLayout forContainer(const ContainerHeader& header, uint64_t container_size);
+};
+
+
+// 接收方公钥：只解析和校验一次，之后为每条消息生成临时密钥时复用
+// 已校验的公钥、编码结果以及临时密钥生成上下文。不是线程安全的，每个线程各持一份。
+class RecipientKey {
+public:
+    explicit RecipientKey(ByteSpan public_key_pem);
+    ~RecipientKey();
+
+    RecipientKey(const RecipientKey&) = delete;
+    RecipientKey& operator=(const RecipientKey&) = delete;
+
+    unsigned char kem() const { return kem_; }
+
+    // 生成临时密钥对，把临时公钥和包装后的数据密钥写入 header
+    void wrap(const unsigned char data_key[ECC_AES_KEY_SIZE / 8], ContainerHeader& header);
+
+private:
+    EVP_PKEY* pkey_;
+    EVP_PKEY_CTX* keygen_ctx_;
+    unsigned char kem_;
+    std::vector<unsigned char> encoded_;
+};
+
+// 接收方私钥：解析一次，用于解包任意数量容器的数据密钥
+class RecipientPrivateKey {
+public:
+    explicit RecipientPrivateKey(ByteSpan private_key_pem);
+    ~RecipientPrivateKey();
+
+    RecipientPrivateKey(const RecipientPrivateKey&) = delete;
+    RecipientPrivateKey& operator=(const RecipientPrivateKey&) = delete;
+
+    void unwrap(const ContainerHeader& header, unsigned char data_key[ECC_AES_KEY_SIZE / 8]) const;
+
+private:
+    EVP_PKEY* pkey_;
+    unsigned char kem_;
+    std::vector<unsigned char> encoded_;
+
+    EVP_PKEY* ephemeralFrom(const ContainerHeader& header) const;
+};
+
+// 新建一个随机数据密钥和 nonce 前缀，并用接收方公钥包装
+ContainerHeader newContainerHeader(RecipientKey& recipient, uint32_t segment_size,
+                                   unsigned char data_key[ECC_AES_KEY_SIZE / 8]);
+
+// 内存中的一次性加密：每次调用生成新的数据密钥和临时密钥。
+// threads > 1 时段在进程内共享的常驻线程池上并行处理，多个线程可以同时调用各自的实例。
+class EnvelopeSealer {
+public:
+    explicit EnvelopeSealer(RecipientKey& recipient, uint32_t segment_size = ECC_AES_DEFAULT_SEGMENT_SIZE,
+                            unsigned int threads = 1);
+
+    size_t sealedSize(size_t plaintext_size) const;
+
+    // out 至少需要 sealedSize(plaintext.size) 字节，返回写入的字节数
+    size_t seal(ByteSpan plaintext, MutableByteSpan out);
+    std::vector<unsigned char> seal(ByteSpan plaintext);
+
+private:
+    RecipientKey& recipient_;
+    uint32_t segment_size_;
+    unsigned int threads_;
+};
+
+// 内存中的一次性解密，支持只解密某个明文区间
+class EnvelopeOpener {
+public:
+    explicit EnvelopeOpener(const RecipientPrivateKey& key, unsigned int threads = 1);
+
+    uint64_t plaintextSize(ByteSpan sealed) const;
+
+    // out 至少需要 plaintextSize(sealed) 字节，返回写入的字节数
+    size_t open(ByteSpan sealed, MutableByteSpan out);
+    std::vector<unsigned char> open(ByteSpan sealed);
+
+    // 解密明文区间 [offset, offset + length)，只处理与之重叠的段
+    size_t openRange(ByteSpan sealed, uint64_t offset, uint64_t length, MutableByteSpan out);
+
+private:
+    const RecipientPrivateKey& key_;
+    unsigned int threads_;
+};
+
+// 段加解密器，实现在库内部
+class SegmentCipher;
+
+// 增量加密：明文可以分多次输入，已确定不是最后一段的段会立即输出
+class SealStream {
+public:
+    explicit SealStream(RecipientKey& recipient, uint32_t segment_size = ECC_AES_DEFAULT_SEGMENT_SIZE);
+    ~SealStream();
+
+    SealStream(const SealStream&) = delete;
+    SealStream& operator=(const SealStream&) = delete;
+
+    // 追加明文，产生的容器字节（首次调用时包括 header）追加到 out
+    void update(ByteSpan plaintext, std::vector<unsigned char>& out);
+
+    // 输出带 last_flag 的最后一段，之后不能再调用 update
+    void finish(std::vector<unsigned char>& out);
+
+private:
+    unsigned char key_[ECC_AES_KEY_SIZE / 8];
+    ContainerHeader header_;
+    std::unique_ptr<SegmentCipher> cipher_;
+    std::vector<unsigned char> pending_;
+    uint64_t next_index_;
+    bool header_written_;
+    bool finished_;
+
+    void writeHeader(std::vector<unsigned char>& out);
+    void sealSegment(const unsigned char* in, size_t len, bool last, std::vector<unsigned char>& out);
+};
+
+// 增量解密：容器字节可以分多次输入，校验通过的明文立即输出；
+// finish() 校验最后一段的 last_flag，未调用 finish() 的输出不能视为完整。
+class OpenStream {
+public:
+    explicit OpenStream(const RecipientPrivateKey& key);
+    ~OpenStream();
+
+    OpenStream(const OpenStream&) = delete;
+    OpenStream& operator=(const OpenStream&) = delete;
+
+    void update(ByteSpan sealed, std::vector<unsigned char>& out);
+    void finish(std::vector<unsigned char>& out);
+
+private:
+    const RecipientPrivateKey& private_key_;
+    unsigned char key_[ECC_AES_KEY_SIZE / 8];
+    ContainerHeader header_;
+    std::vector<unsigned char> pending_;
+    std::vector<unsigned char> header_bytes_;
+    std::unique_ptr<SegmentCipher> cipher_;
+    uint64_t next_index_;
+    bool finished_;
+
+    void parseHeader(ByteSpan sealed, size_t& pos);
+    void openSegment(const unsigned char* in, size_t len, bool last, std::vector<unsigned char>& out);
+};
+
+} // namespace ecc_aes
+
+#endif // ECC_AES_CORE_H
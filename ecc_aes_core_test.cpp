@@ -0,0 +1,224 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/rand.h>
+
+#include "ecc_aes_core.h"
+
+using ecc_aes::ByteSpan;
+using ecc_aes::EnvelopeOpener;
+using ecc_aes::EnvelopeSealer;
+using ecc_aes::MutableByteSpan;
+using ecc_aes::OpenStream;
+using ecc_aes::RecipientKey;
+using ecc_aes::RecipientPrivateKey;
+using ecc_aes::SealStream;
+
+// 容器格式的回归测试：往返、段边界、篡改检测、区间解密以及流式接口与一次性接口的互通。
+// 段大小取得很小，少量数据就能覆盖多段的情况。失败时打印用例名，退出码为失败数。
+
+namespace {
+
+const uint32_t kSegmentSize = 64;
+
+int failures = 0;
+
+void check(bool condition, const std::string& name) {
+    if (!condition) {
+        std::cerr << "FAILED: " << name << std::endl;
+        ++failures;
+    }
+}
+
+// 期望 fn 抛出 std::runtime_error（认证或格式错误）
+void checkRejected(const std::function<void()>& fn, const std::string& name) {
+    try {
+        fn();
+    } catch (const std::runtime_error&) {
+        return;
+    }
+    check(false, name + " (not rejected)");
+}
+
+// 生成一对临时密钥，返回 PEM 编码的公钥和私钥
+void generateKeyPair(const char* kem, std::string& public_pem, std::string& private_pem) {
+    EVP_PKEY* pkey = std::string(kem) == "P-256" ? EVP_PKEY_Q_keygen(nullptr, nullptr, "EC", "P-256")
+                                                 : EVP_PKEY_Q_keygen(nullptr, nullptr, kem);
+    if (pkey == nullptr) {
+        throw std::runtime_error(std::string("Error generating ") + kem + " test key pair.");
+    }
+    BIO* pub = BIO_new(BIO_s_mem());
+    BIO* priv = BIO_new(BIO_s_mem());
+    PEM_write_bio_PUBKEY(pub, pkey);
+    PEM_write_bio_PrivateKey(priv, pkey, nullptr, nullptr, 0, nullptr, nullptr);
+    char* data = nullptr;
+    long len = BIO_get_mem_data(pub, &data);
+    public_pem.assign(data, len);
+    len = BIO_get_mem_data(priv, &data);
+    private_pem.assign(data, len);
+    BIO_free(pub);
+    BIO_free(priv);
+    EVP_PKEY_free(pkey);
+}
+
+std::vector<unsigned char> randomBytes(size_t size) {
+    std::vector<unsigned char> bytes(size);
+    if (size > 0 && RAND_bytes(bytes.data(), static_cast<int>(size)) != 1) {
+        throw std::runtime_error("Error generating test data.");
+    }
+    return bytes;
+}
+
+// 按 chunks 循环给出的块大小把 data 分多次送入 update
+template <typename Stream>
+std::vector<unsigned char> streamChunked(Stream& stream, const std::vector<unsigned char>& data,
+                                         const std::vector<size_t>& chunks) {
+    std::vector<unsigned char> out;
+    size_t pos = 0;
+    for (size_t i = 0; pos < data.size(); ++i) {
+        const size_t len = std::min(chunks[i % chunks.size()], data.size() - pos);
+        stream.update(ByteSpan(data.data() + pos, len), out);
+        pos += len;
+    }
+    stream.finish(out);
+    return out;
+}
+
+void testRoundTrip(const std::string& kem, RecipientKey& recipient, const RecipientPrivateKey& private_key) {
+    // 空明文、不足一段、恰好一段、恰好整数段以及末段不满
+    for (size_t size : {size_t(0), size_t(1), size_t(kSegmentSize - 1), size_t(kSegmentSize),
+                        size_t(3 * kSegmentSize), size_t(3 * kSegmentSize + 17)}) {
+        for (unsigned int threads : {1u, 3u}) {
+            const std::string name = kem + " round trip size=" + std::to_string(size) +
+                                     " threads=" + std::to_string(threads);
+            const std::vector<unsigned char> plaintext = randomBytes(size);
+            EnvelopeSealer sealer(recipient, kSegmentSize, threads);
+            EnvelopeOpener opener(private_key, threads);
+            const std::vector<unsigned char> sealed = sealer.seal(ByteSpan(plaintext));
+            check(sealed.size() == sealer.sealedSize(size), name + " sealedSize");
+            check(opener.plaintextSize(ByteSpan(sealed)) == size, name + " plaintextSize");
+            check(opener.open(ByteSpan(sealed)) == plaintext, name);
+        }
+    }
+}
+
+void testTampering(const std::string& kem, RecipientKey& recipient, const RecipientPrivateKey& private_key) {
+    const std::vector<unsigned char> plaintext = randomBytes(3 * kSegmentSize);
+    EnvelopeSealer sealer(recipient, kSegmentSize);
+    EnvelopeOpener opener(private_key);
+    const std::vector<unsigned char> sealed = sealer.seal(ByteSpan(plaintext));
+    const size_t header_size = ecc_aes::ContainerHeader::parse(ByteSpan(sealed)).size();
+    const size_t stored_size = kSegmentSize + ECC_AES_GCM_TAG_SIZE;
+
+    // 在段边界处截断：剩下的每段都能单独通过认证，只有 last_flag 能发现
+    for (size_t segments : {size_t(1), size_t(2)}) {
+        const std::vector<unsigned char> truncated(sealed.begin(), sealed.begin() + header_size + segments * stored_size);
+        checkRejected([&] { opener.open(ByteSpan(truncated)); },
+                      kem + " truncated to " + std::to_string(segments) + " segments");
+        checkRejected([&] {
+            OpenStream stream(private_key);
+            streamChunked(stream, truncated, {stored_size});
+        }, kem + " stream truncated to " + std::to_string(segments) + " segments");
+    }
+
+    std::vector<unsigned char> swapped = sealed;
+    std::swap_ranges(swapped.begin() + header_size, swapped.begin() + header_size + stored_size,
+                     swapped.begin() + header_size + stored_size);
+    checkRejected([&] { opener.open(ByteSpan(swapped)); }, kem + " swapped segments");
+
+    std::vector<unsigned char> flipped = sealed;
+    flipped.back() ^= 0x01;
+    checkRejected([&] { opener.open(ByteSpan(flipped)); }, kem + " flipped tag byte");
+
+    // 保留字节参与 AAD 的重建，非零值必须在解析时拒绝
+    for (size_t offset : {size_t(6), size_t(7), size_t(19)}) {
+        std::vector<unsigned char> reserved = sealed;
+        reserved[offset] = 0x01;
+        checkRejected([&] { opener.open(ByteSpan(reserved)); },
+                      kem + " nonzero reserved byte " + std::to_string(offset));
+    }
+}
+
+void testOpenRange(const std::string& kem, RecipientKey& recipient, const RecipientPrivateKey& private_key) {
+    const std::vector<unsigned char> plaintext = randomBytes(3 * kSegmentSize + 17);
+    EnvelopeSealer sealer(recipient, kSegmentSize);
+    const std::vector<unsigned char> sealed = sealer.seal(ByteSpan(plaintext));
+    const uint64_t edge = kSegmentSize;
+    const std::vector<std::pair<uint64_t, uint64_t>> ranges = {
+        {0, 1}, {edge - 1, 2}, {edge, edge}, {edge - 5, edge + 10}, {0, plaintext.size()},
+        {3 * edge, 17}, {plaintext.size() - 1, 1}, {edge, 0},
+    };
+    for (unsigned int threads : {1u, 3u}) {
+        EnvelopeOpener opener(private_key, threads);
+        for (const auto& range : ranges) {
+            const std::string name = kem + " openRange offset=" + std::to_string(range.first) +
+                                     " length=" + std::to_string(range.second) + " threads=" + std::to_string(threads);
+            std::vector<unsigned char> out(range.second);
+            const size_t written = opener.openRange(ByteSpan(sealed), range.first, range.second, MutableByteSpan(out));
+            check(written == range.second &&
+                  std::equal(out.begin(), out.end(), plaintext.begin() + range.first), name);
+        }
+        std::vector<unsigned char> out(2);
+        checkRejected([&] { opener.openRange(ByteSpan(sealed), plaintext.size() - 1, 2, MutableByteSpan(out)); },
+                      kem + " openRange past end");
+    }
+}
+
+void testStreams(const std::string& kem, RecipientKey& recipient, const RecipientPrivateKey& private_key) {
+    // 块大小与段大小互不对齐，覆盖单字节、跨多段和恰好落在段边界的输入
+    const std::vector<size_t> chunks = {1, 7, kSegmentSize, 3, 2 * kSegmentSize + 5, kSegmentSize - 1};
+    for (size_t size : {size_t(0), size_t(kSegmentSize), size_t(5 * kSegmentSize), size_t(5 * kSegmentSize + 9)}) {
+        const std::string name = kem + " stream size=" + std::to_string(size);
+        const std::vector<unsigned char> plaintext = randomBytes(size);
+        EnvelopeOpener opener(private_key);
+
+        // SealStream 的输出与 EnvelopeSealer 格式相同，两种解密接口都能打开
+        SealStream seal_stream(recipient, kSegmentSize);
+        const std::vector<unsigned char> streamed = streamChunked(seal_stream, plaintext, chunks);
+        check(streamed.size() == EnvelopeSealer(recipient, kSegmentSize).sealedSize(size), name + " sealed size");
+        check(opener.open(ByteSpan(streamed)) == plaintext, name + " SealStream -> EnvelopeOpener");
+
+        EnvelopeSealer sealer(recipient, kSegmentSize);
+        const std::vector<unsigned char> sealed = sealer.seal(ByteSpan(plaintext));
+        OpenStream open_stream(private_key);
+        check(streamChunked(open_stream, sealed, chunks) == plaintext, name + " EnvelopeSealer -> OpenStream");
+
+        OpenStream round_trip(private_key);
+        check(streamChunked(round_trip, streamed, {1, 13, kSegmentSize + ECC_AES_GCM_TAG_SIZE}) == plaintext,
+              name + " SealStream -> OpenStream");
+    }
+}
+
+}
+
+int main() {
+    try {
+        for (const char* kem : {"X25519", "P-256"}) {
+            std::string public_pem;
+            std::string private_pem;
+            generateKeyPair(kem, public_pem, private_pem);
+            RecipientKey recipient{ByteSpan(public_pem)};
+            RecipientPrivateKey private_key{ByteSpan(private_pem)};
+            check(recipient.kem() == (std::string(kem) == "X25519" ? ECC_AES_KEM_X25519 : ECC_AES_KEM_P256),
+                  std::string(kem) + " kem");
+
+            testRoundTrip(kem, recipient, private_key);
+            testTampering(kem, recipient, private_key);
+            testOpenRange(kem, recipient, private_key);
+            testStreams(kem, recipient, private_key);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    if (failures == 0) {
+        std::cout << "All container tests passed." << std::endl;
+    }
+    return failures;
+}
@@ -0,0 +1,238 @@
+#ifndef ECC_AES_FILE_H
+#define ECC_AES_FILE_H
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <cstdint>
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+#include <openssl/crypto.h>
+
+#include "ecc_aes_internal.h"
+#include "trace.h"
+
+// 基于 ecc_aes_core 的文件加解密：按批读取段并行处理，区间解密只读取重叠的段
+class SecureECCAESFileEncryptor {
+private:
+    const char* input_file_;
+    const char* output_file_;
+    const char* key_file_;
+    unsigned char aes_key_[ECC_AES_KEY_SIZE / 8];
+    uint32_t segment_size_;
+    unsigned int num_threads_;
+
+    std::string readKeyFile() const {
+        std::ifstream key_file(key_file_);
+        if (!key_file.is_open()) {
+            throw std::runtime_error(std::string("Error opening key file ") + key_file_ + ".");
+        }
+        std::ostringstream pem;
+        pem << key_file.rdbuf();
+        return pem.str();
+    }
+
+    // 解密需要随机访问，输入必须是可定位的普通文件
+    static uint64_t fileSize(std::ifstream& file) {
+        file.seekg(0, std::ios::end);
+        const std::streamoff size = file.tellg();
+        file.seekg(0, std::ios::beg);
+        if (size < 0 || !file) {
+            throw std::runtime_error("Encrypted input must be a seekable file.");
+        }
+        return static_cast<uint64_t>(size);
+    }
+
+    void encryptFile(std::ifstream& input_file, std::ofstream& output_file) {
+        AIK_TRACE_SCOPE("encryptFile");
+        // 生成 AES 数据密钥并用接收方公钥包装
+        const std::string pem = readKeyFile();
+        ecc_aes::RecipientKey recipient{ecc_aes::ByteSpan(pem)};
+        const ecc_aes::ContainerHeader header = ecc_aes::newContainerHeader(recipient, segment_size_, aes_key_);
+        const std::vector<unsigned char> header_bytes = header.serialize();
+        output_file.write(reinterpret_cast<const char*>(header_bytes.data()), header_bytes.size());
+
+        // 输入按批读取直到 EOF，不要求可定位（管道、/dev/stdin 均可）。
+        // 读满一批后再试探一个字节：只有到达 EOF 时才能确定哪一段是最后一段
+        const size_t batch = static_cast<size_t>(num_threads_) * ECC_AES_SEGMENTS_PER_WORKER;
+        std::vector<unsigned char> plaintext;
+        std::vector<unsigned char> ciphertext;
+        for (uint64_t first = 0;; first += batch) {
+            size_t bytes = 0;
+            {
+                AIK_TRACE_SCOPE("read_batch");
+                // 缓冲区逐段扩大，小输入只分配实际用到的大小
+                while (bytes < batch * segment_size_ && input_file) {
+                    if (plaintext.size() < bytes + segment_size_) {
+                        plaintext.resize(bytes + segment_size_);
+                    }
+                    input_file.read(reinterpret_cast<char*>(plaintext.data() + bytes), segment_size_);
+                    bytes += static_cast<size_t>(input_file.gcount());
+                }
+                if (input_file.bad()) {
+                    throw std::runtime_error("Error reading input file.");
+                }
+            }
+            const bool last = !input_file || input_file.peek() == std::char_traits<char>::eof();
+
+            // 空输入也输出一个带 last_flag 的空段
+            const size_t count = std::max<size_t>(1, (bytes + segment_size_ - 1) / segment_size_);
+            if (first + count - 1 > UINT32_MAX) {
+                throw std::runtime_error("Input too large for container format.");
+            }
+            const size_t sealed = bytes + count * ECC_AES_GCM_TAG_SIZE;
+            if (ciphertext.size() < sealed) {
+                ciphertext.resize(sealed);
+            }
+            // 不是最后一批时段总数未知，传入 UINT64_MAX 使本批各段都不带 last_flag
+            ecc_aes::sealSegments(header, aes_key_, first, last ? first + count : UINT64_MAX,
+                                  ecc_aes::ByteSpan(plaintext.data(), bytes), ecc_aes::MutableByteSpan(ciphertext),
+                                  num_threads_);
+
+            // 批内除最后一段外都是满段，因此密文是连续的
+            {
+                AIK_TRACE_SCOPE("write_batch");
+                output_file.write(reinterpret_cast<char*>(ciphertext.data()), sealed);
+            }
+            if (last) {
+                break;
+            }
+        }
+    }
+
+    // 解密明文区间 [offset, offset + length)，只读取与之重叠的段
+    void decryptRange(std::ifstream& input_file, std::ofstream& output_file, uint64_t offset, uint64_t length,
+                      bool whole_file) {
+        AIK_TRACE_SCOPE("decryptRange");
+        const uint64_t file_size = fileSize(input_file);
+        std::vector<unsigned char> header_bytes(static_cast<size_t>(std::min<uint64_t>(file_size, ECC_AES_MAX_CONTAINER_HEADER_SIZE)));
+        input_file.read(reinterpret_cast<char*>(header_bytes.data()), header_bytes.size());
+        const ecc_aes::ContainerHeader header = ecc_aes::ContainerHeader::parse(ecc_aes::ByteSpan(header_bytes));
+        const ecc_aes::ContainerLayout layout = ecc_aes::ContainerLayout::forContainer(header, file_size);
+
+        // 用接收方私钥解包数据密钥
+        std::string pem = readKeyFile();
+        ecc_aes::RecipientPrivateKey recipient{ecc_aes::ByteSpan(pem)};
+        OPENSSL_cleanse(&pem[0], pem.size());
+        recipient.unwrap(header, aes_key_);
+
+        if (whole_file) {
+            offset = 0;
+            length = layout.plaintext_size;
+        } else if (offset > layout.plaintext_size || length > layout.plaintext_size - offset) {
+            throw std::runtime_error("Requested range exceeds plaintext size " + std::to_string(layout.plaintext_size) + ".");
+        }
+
+        // 整个文件解密时即使明文为空也要校验最后一段，以检测截断
+        uint64_t first_segment = offset / header.segment_size;
+        uint64_t end_segment = length == 0 ? first_segment : (offset + length - 1) / header.segment_size + 1;
+        if (whole_file) {
+            end_segment = layout.segment_count;
+        }
+
+        // 按文件中实际存在的字节数分配缓冲区，不能只信任 header 中的 segment_size；
+        // 每段明文都比存储的密文短，因此明文缓冲区与密文缓冲区等长即可
+        const size_t batch = static_cast<size_t>(num_threads_) * ECC_AES_SEGMENTS_PER_WORKER;
+        const uint64_t stored_begin = layout.header_size + first_segment * layout.stored_segment_size;
+        std::vector<unsigned char> ciphertext(static_cast<size_t>(
+            std::min<uint64_t>(batch * layout.stored_segment_size, file_size - std::min(file_size, stored_begin))));
+        std::vector<unsigned char> plaintext(ciphertext.size());
+        input_file.seekg(stored_begin, std::ios::beg);
+
+        for (uint64_t first = first_segment; first < end_segment; first += batch) {
+            const size_t count = static_cast<size_t>(std::min<uint64_t>(batch, end_segment - first));
+            const uint64_t stored_offset = layout.header_size + first * layout.stored_segment_size;
+            const size_t bytes = static_cast<size_t>(std::min<uint64_t>(count * layout.stored_segment_size, file_size - stored_offset));
+            {
+                AIK_TRACE_SCOPE("read_batch");
+                if (!input_file.read(reinterpret_cast<char*>(ciphertext.data()), bytes)) {
+                    throw std::runtime_error("Error reading encrypted file.");
+                }
+            }
+
+            const size_t opened = ecc_aes::openSegments(header, aes_key_, first, layout.segment_count,
+                                                        ecc_aes::ByteSpan(ciphertext.data(), bytes),
+                                                        ecc_aes::MutableByteSpan(plaintext), num_threads_);
+
+            // 只输出与请求区间重叠的部分
+            const uint64_t batch_begin = first * header.segment_size;
+            const uint64_t batch_end = batch_begin + opened;
+            const uint64_t begin = std::max(batch_begin, offset);
+            const uint64_t end = std::min(batch_end, offset + length);
+            if (end > begin) {
+                AIK_TRACE_SCOPE("write_batch");
+                output_file.write(reinterpret_cast<char*>(plaintext.data() + (begin - batch_begin)), end - begin);
+            }
+        }
+    }
+
+public:
+    SecureECCAESFileEncryptor(const char* input_file, const char* output_file, const char* key_file)
+        : input_file_(input_file), output_file_(output_file), key_file_(key_file), segment_size_(ECC_AES_DEFAULT_SEGMENT_SIZE),
+          num_threads_(std::max(1u, std::thread::hardware_concurrency())) {}
+
+    void encrypt_decrypt_file(bool encrypt) {
+        process_file(encrypt, 0, 0, true);
+    }
+
+    ~SecureECCAESFileEncryptor() {
+        OPENSSL_cleanse(aes_key_, sizeof(aes_key_));
+    }
+
+    // 调整段大小（仅影响加密）和并行线程数
+    void set_segment_size(uint32_t segment_size) {
+        if (segment_size == 0 || segment_size > ECC_AES_MAX_SEGMENT_SIZE) {
+            throw std::invalid_argument("Segment size must be between 1 and " + std::to_string(ECC_AES_MAX_SEGMENT_SIZE) + ".");
+        }
+        segment_size_ = segment_size;
+    }
+
+    void set_threads(unsigned int threads) {
+        num_threads_ = std::max(1u, threads);
+    }
+
+    void process_file(bool encrypt, uint64_t offset, uint64_t length, bool whole_file) {
+    // 打开输入文件和输出文件
+    std::ifstream input_file(input_file_, std::ios::binary);
+    std::ofstream output_file(output_file_, std::ios::binary);
+
+    if (!input_file.is_open() || !output_file.is_open()) {
+        throw std::runtime_error("Error opening files.");
+    }
+
+    // 失败时删除已写出的部分输出，避免留下未经完整校验的明文
+    try {
+        if (encrypt) {
+            encryptFile(input_file, output_file);
+        } else {
+            decryptRange(input_file, output_file, offset, length, whole_file);
+        }
+    } catch (...) {
+        output_file.close();
+        std::remove(output_file_);
+        throw;
+    }
+
+    input_file.close();
+    output_file.close();
+}
+
+
+    void runEncryption() {
+        encrypt_decrypt_file(true);
+    }
+
+    void runDecryption() {
+        encrypt_decrypt_file(false);
+    }
+
+    void runRangeDecryption(uint64_t offset, uint64_t length) {
+        process_file(false, offset, length, false);
+    }
+
+};
+
+#endif // ECC_AES_FILE_H
@@ -0,0 +1,72 @@
+#ifndef ECC_AES_INTERNAL_H
+#define ECC_AES_INTERNAL_H
+
+// ecc_aes_core 的内部接口：只供库本身和本仓库中的文件工具使用，不随库安装
+
+#include "ecc_aes_core.h"
+
+#define ECC_AES_SEGMENTS_PER_WORKER 16
+
+namespace ecc_aes {
+
+// 每线程的 EVP_CIPHER_CTX 池。上下文在线程内复用而不是每次调用分配/释放
+// （多线程加解密使用常驻线程池，因此工作线程的池同样跨调用保留）。
+// 一次借用期间记住当前装载的密钥：同一密钥连续使用时只需重设 nonce，省去 AES 密钥扩展；
+// 归还时抹掉密钥，池中空闲的上下文不保留密钥材料。
+class CipherContextPool {
+public:
+    struct Entry;
+
+    class Lease {
+    public:
+        explicit Lease(Entry* entry) : entry_(entry) {}
+        Lease(Lease&& other) : entry_(other.entry_) { other.entry_ = nullptr; }
+        ~Lease();
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease& operator=(Lease&&) = delete;
+
+        // 以 AES-256-GCM 初始化一次加密或解密，密钥未变时跳过密钥扩展
+        EVP_CIPHER_CTX* init(const unsigned char key[ECC_AES_KEY_SIZE / 8],
+                             const unsigned char nonce[ECC_AES_GCM_IV_SIZE], bool encrypt);
+
+    private:
+        Entry* entry_;
+    };
+
+    static Lease acquire();
+};
+
+// 段加解密器，持有一个从当前线程池中借出的上下文
+class SegmentCipher {
+public:
+    SegmentCipher(const unsigned char* key, const ContainerHeader& header);
+
+    // 加密一段，out 需容纳 len + ECC_AES_GCM_TAG_SIZE 字节
+    void seal(uint64_t index, bool last, const unsigned char* in, size_t len, unsigned char* out);
+
+    // 解密并校验一段，in 为 len 字节密文加 ECC_AES_GCM_TAG_SIZE 字节 tag
+    void open(uint64_t index, bool last, const unsigned char* in, size_t len, unsigned char* out);
+
+private:
+    CipherContextPool::Lease lease_;
+    const unsigned char* key_;
+    const ContainerHeader& header_;
+    std::vector<unsigned char> aad_;
+
+    void makeNonce(uint64_t index, bool last, unsigned char nonce[ECC_AES_GCM_IV_SIZE]) const;
+};
+
+// 加密从 first_index 开始的连续若干段，段数由 plaintext 长度决定（空明文视为一个空段）；
+// segment_count 为整个容器的段数，用于确定 last_flag。out 需容纳密文和各段 tag。
+void sealSegments(const ContainerHeader& header, const unsigned char* key, uint64_t first_index,
+                  uint64_t segment_count, ByteSpan plaintext, MutableByteSpan out, unsigned int threads);
+
+// 解密并校验从 first_index 开始的连续若干已存储段，返回写入 out 的明文字节数
+size_t openSegments(const ContainerHeader& header, const unsigned char* key, uint64_t first_index,
+                    uint64_t segment_count, ByteSpan ciphertext, MutableByteSpan out, unsigned int threads);
+
+} // namespace ecc_aes
+
+#endif // ECC_AES_INTERNAL_H
@@ -0,0 +1,270 @@
+#ifndef AIK_TRACE_H
+#define AIK_TRACE_H
+
+// 轻量级热点路径追踪，header-only。
+//
+// 编译时定义 AIK_TRACING 启用（CMake: -DENABLE_TRACING=ON），否则所有宏展开为空语句、不产生任何代码，
+// 宏参数也不会被求值。启用时：
+//   AIK_TRACE_SCOPE("name")          RAII 区间，作用域结束时记录一个完整事件
+//   AIK_TRACE_COUNTER("name", value) 记录计数器的当前值
+//   AIK_TRACE_THREAD_NAME("name")    为当前线程命名
+//   AIK_TRACE_FLUSH()                立即写出目前为止的全部事件
+// 名称必须是字符串字面量（或其它静态生存期的字符串），只保存指针。
+//
+// 每个线程写自己的分块缓冲区，写入路径无锁；进程退出时（或调用 AIK_TRACE_FLUSH()）
+// 把全部事件按 Chrome trace-event JSON 格式写到环境变量 AIK_TRACE_FILE 指定的文件，
+// 默认 trace.json，可直接在 chrome://tracing 或 ui.perfetto.dev 中打开。
+//
+// 内存有上限：每个线程最多保留 AIK_TRACE_MAX_EVENTS_PER_THREAD 个事件（默认 256K，约 8 MiB），
+// 之后的事件丢弃不记录，丢弃数量以 trace_dropped_events 计数器写入输出。
+// flush 可以重复调用，每次都先写临时文件再改名，用完整快照覆盖上一次的输出；长时间运行的程序
+// 应定期调用 AIK_TRACE_FLUSH()，这样被 Ctrl-C 等信号终止时只丢失最后一次 flush 之后的事件。
+
+#ifdef AIK_TRACING
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+#ifndef AIK_TRACE_MAX_EVENTS_PER_THREAD
+#define AIK_TRACE_MAX_EVENTS_PER_THREAD (256 * 1024)
+#endif
+
+namespace aik_trace {
+
+struct Event {
+    const char* name;
+    uint64_t ts_ns;
+    int64_t value; // 'X': 持续时间 (ns)，'C': 计数器值
+    char phase;
+};
+
+struct Chunk {
+    static const size_t kCapacity = 4096;
+
+    Event events[kCapacity];
+    std::atomic<size_t> count;
+    std::atomic<Chunk*> next;
+
+    Chunk() : count(0), next(nullptr) {}
+};
+
+// 只有所属线程写入；发布新事件时先写内容再 release 计数，读者 acquire 计数后读取。
+// 分块数达到上限后不再分配，新事件只计入 dropped。
+struct ThreadBuffer {
+    static const size_t kMaxChunks = (AIK_TRACE_MAX_EVENTS_PER_THREAD + Chunk::kCapacity - 1) / Chunk::kCapacity;
+
+    uint32_t tid;
+    std::atomic<const char*> name;
+    std::atomic<uint64_t> dropped;
+    Chunk* head;
+    Chunk* tail;
+    size_t chunks;
+    ThreadBuffer* next;
+
+    explicit ThreadBuffer(uint32_t id)
+        : tid(id), name(nullptr), dropped(0), head(new Chunk), tail(head), chunks(1), next(nullptr) {}
+
+    void append(const char* event_name, uint64_t ts_ns, int64_t value, char phase) {
+        size_t n = tail->count.load(std::memory_order_relaxed);
+        if (n == Chunk::kCapacity) {
+            if (chunks >= kMaxChunks) {
+                dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return;
+            }
+            Chunk* chunk = new Chunk;
+            ++chunks;
+            tail->next.store(chunk, std::memory_order_release);
+            tail = chunk;
+            n = 0;
+        }
+        Event& event = tail->events[n];
+        event.name = event_name;
+        event.ts_ns = ts_ns;
+        event.value = value;
+        event.phase = phase;
+        tail->count.store(n + 1, std::memory_order_release);
+    }
+};
+
+class Session {
+public:
+    Session() : threads_(nullptr), next_tid_(1), start_(std::chrono::steady_clock::now()) {}
+
+    ~Session() {
+        flush();
+    }
+
+    uint64_t now() const {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count());
+    }
+
+    // 线程缓冲区以无锁链表登记；线程退出后缓冲区保留到进程结束，以便最后统一输出
+    ThreadBuffer* registerThread() {
+        ThreadBuffer* buffer = new ThreadBuffer(next_tid_.fetch_add(1, std::memory_order_relaxed));
+        ThreadBuffer* head = threads_.load(std::memory_order_relaxed);
+        do {
+            buffer->next = head;
+        } while (!threads_.compare_exchange_weak(head, buffer, std::memory_order_release, std::memory_order_relaxed));
+        return buffer;
+    }
+
+    // 写出到目前为止记录的全部事件；可重复调用，记录线程无需暂停
+    void flush() {
+        std::lock_guard<std::mutex> lock(flush_mutex_);
+        const char* env = std::getenv("AIK_TRACE_FILE");
+        const std::string path = env != nullptr && *env != '\0' ? env : "trace.json";
+        const std::string tmp_path = path + ".tmp";
+        const uint64_t flush_ts = now();
+        std::ofstream out(tmp_path, std::ios::out | std::ios::trunc);
+        if (!out) {
+            std::cerr << "ERROR: Unable to write trace file " << tmp_path << std::endl;
+            return;
+        }
+
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        for (ThreadBuffer* buffer = threads_.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->next) {
+            const char* thread_name = buffer->name.load(std::memory_order_acquire);
+            separator(out, first);
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+                << ",\"args\":{\"name\":\"";
+            if (thread_name != nullptr) {
+                writeEscaped(out, thread_name);
+            } else {
+                out << "thread " << buffer->tid;
+            }
+            out << "\"}}";
+
+            for (Chunk* chunk = buffer->head; chunk != nullptr; chunk = chunk->next.load(std::memory_order_acquire)) {
+                const size_t count = chunk->count.load(std::memory_order_acquire);
+                for (size_t i = 0; i < count; ++i) {
+                    separator(out, first);
+                    writeEvent(out, buffer->tid, chunk->events[i]);
+                }
+            }
+            const uint64_t dropped = buffer->dropped.load(std::memory_order_relaxed);
+            if (dropped != 0) {
+                const Event event = {"trace_dropped_events", flush_ts, static_cast<int64_t>(dropped), 'C'};
+                separator(out, first);
+                writeEvent(out, buffer->tid, event);
+            }
+        }
+        out << "]}" << std::endl;
+        out.close();
+
+        // 整体替换，中途被终止也不会留下写了一半的 JSON
+        if (!out || (std::rename(tmp_path.c_str(), path.c_str()) != 0 &&
+                     (std::remove(path.c_str()), std::rename(tmp_path.c_str(), path.c_str()) != 0))) {
+            std::cerr << "ERROR: Unable to write trace file " << path << std::endl;
+        }
+    }
+
+private:
+    std::atomic<ThreadBuffer*> threads_;
+    std::atomic<uint32_t> next_tid_;
+    std::chrono::steady_clock::time_point start_;
+    std::mutex flush_mutex_;
+
+    static void separator(std::ostream& out, bool& first) {
+        if (!first) {
+            out << ",\n";
+        }
+        first = false;
+    }
+
+    static void writeEscaped(std::ostream& out, const char* text) {
+        for (; *text != '\0'; ++text) {
+            if (*text == '"' || *text == '\\') {
+                out << '\\';
+            }
+            out << *text;
+        }
+    }
+
+    // Chrome trace-event 的时间单位是微秒，保留纳秒精度
+    static void writeMicros(std::ostream& out, uint64_t ns) {
+        out << ns / 1000 << '.' << std::setw(3) << std::setfill('0') << ns % 1000 << std::setfill(' ');
+    }
+
+    static void writeEvent(std::ostream& out, uint32_t tid, const Event& event) {
+        out << "{\"name\":\"";
+        writeEscaped(out, event.name);
+        out << "\",\"ph\":\"" << event.phase << "\",\"pid\":1,\"tid\":" << tid << ",\"ts\":";
+        writeMicros(out, event.ts_ns);
+        if (event.phase == 'X') {
+            out << ",\"dur\":";
+            writeMicros(out, static_cast<uint64_t>(event.value));
+        } else {
+            out << ",\"args\":{\"value\":" << event.value << "}";
+        }
+        out << "}";
+    }
+};
+
+inline Session& session() {
+    static Session instance;
+    return instance;
+}
+
+inline ThreadBuffer& threadBuffer() {
+    thread_local ThreadBuffer* buffer = session().registerThread();
+    return *buffer;
+}
+
+inline void flush() {
+    session().flush();
+}
+
+inline void counter(const char* name, int64_t value) {
+    threadBuffer().append(name, session().now(), value, 'C');
+}
+
+inline void threadName(const char* name) {
+    threadBuffer().name.store(name, std::memory_order_release);
+}
+
+class ScopedSpan {
+public:
+    explicit ScopedSpan(const char* name) : name_(name), start_(session().now()) {}
+
+    ~ScopedSpan() {
+        const uint64_t end = session().now();
+        threadBuffer().append(name_, start_, static_cast<int64_t>(end - start_), 'X');
+    }
+
+    ScopedSpan(const ScopedSpan&) = delete;
+    ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+private:
+    const char* name_;
+    uint64_t start_;
+};
+
+} // namespace aik_trace
+
+#define AIK_TRACE_CONCAT_INNER(a, b) a##b
+#define AIK_TRACE_CONCAT(a, b) AIK_TRACE_CONCAT_INNER(a, b)
+#define AIK_TRACE_SCOPE(name) ::aik_trace::ScopedSpan AIK_TRACE_CONCAT(aik_trace_span_, __LINE__)(name)
+#define AIK_TRACE_COUNTER(name, value) ::aik_trace::counter((name), static_cast<int64_t>(value))
+#define AIK_TRACE_THREAD_NAME(name) ::aik_trace::threadName(name)
+#define AIK_TRACE_FLUSH() ::aik_trace::flush()
+
+#else
+
+#define AIK_TRACE_SCOPE(name) ((void)0)
+#define AIK_TRACE_COUNTER(name, value) ((void)0)
+#define AIK_TRACE_THREAD_NAME(name) ((void)0)
+#define AIK_TRACE_FLUSH() ((void)0)
+
+#endif // AIK_TRACING
+
+#endif // AIK_TRACE_H